@@ -3,6 +3,7 @@
 #include <ppltasks.h>
 
 #include "syslog.hpp"
+#include "syslog/receiver/flight.hpp"
 #include "system.hpp"
 #include "backtask.hxx"
 
@@ -149,6 +150,8 @@ namespace WarGrey::SCADA {
 				} catch (std::exception& e) {
 					syslog(Log::Panic, L"Unhandled Error: %S", e.what());
 				}
+
+				WarGrey::SCADA::flight_recorder_dump();
 			}
 		}
 	};
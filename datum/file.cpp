@@ -13,7 +13,7 @@ static inline bool char_whitespace(char ch) {
 }
 
 template<typename C>
-static void read_basic_text(std::basic_string<C>& str, std::filebuf& src, bool (*end_of_text)(char)) {
+static void read_basic_text(std::basic_string<C>& str, std::streambuf& src, bool (*end_of_text)(char)) {
 	char ch;
 
 	discard_space(src);
@@ -61,17 +61,17 @@ bool WarGrey::SCADA::char_end_of_field(char ch) {
 }
 
 /************************************************************************************************/
-char WarGrey::SCADA::peek_char(std::filebuf& src) {
+char WarGrey::SCADA::peek_char(std::streambuf& src) {
 	return src.sgetc();
 }
 
-char WarGrey::SCADA::read_char(std::filebuf& src) {
+char WarGrey::SCADA::read_char(std::streambuf& src) {
 	discard_space(src);
 
 	return src.sbumpc();
 }
 
-size_t WarGrey::SCADA::read_bytes(std::filebuf& src, char* bs, size_t start, size_t end, bool terminating) {
+size_t WarGrey::SCADA::read_bytes(std::streambuf& src, char* bs, size_t start, size_t end, bool terminating) {
 	size_t idx = start;
 	char ch;
 
@@ -90,7 +90,7 @@ size_t WarGrey::SCADA::read_bytes(std::filebuf& src, char* bs, size_t start, siz
 	return (idx - start);
 }
 
-bool WarGrey::SCADA::read_bool(std::filebuf& src) {
+bool WarGrey::SCADA::read_bool(std::streambuf& src) {
 	long long n = read_integer(src);
 
 	/** WARNING
@@ -101,7 +101,7 @@ bool WarGrey::SCADA::read_bool(std::filebuf& src) {
 	return (n > 0);
 }
 
-std::basic_string<unsigned char> WarGrey::SCADA::read_bytes(std::filebuf& src, bool (*end_of_text)(char)) {
+std::basic_string<unsigned char> WarGrey::SCADA::read_bytes(std::streambuf& src, bool (*end_of_text)(char)) {
 	std::basic_string<unsigned char> str;
 	
 	read_basic_text(str, src, end_of_text);
@@ -109,7 +109,7 @@ std::basic_string<unsigned char> WarGrey::SCADA::read_bytes(std::filebuf& src, b
 	return str;
 }
 
-std::string WarGrey::SCADA::read_text(std::filebuf& src, bool (*end_of_text)(char)) {
+std::string WarGrey::SCADA::read_text(std::streambuf& src, bool (*end_of_text)(char)) {
 	std::string str;
 	
 	read_basic_text(str, src, end_of_text);
@@ -117,11 +117,11 @@ std::string WarGrey::SCADA::read_text(std::filebuf& src, bool (*end_of_text)(cha
 	return str;
 }
 
-Platform::String^ WarGrey::SCADA::read_wtext(std::filebuf& src, bool (*end_of_text)(char)) {
+Platform::String^ WarGrey::SCADA::read_wtext(std::streambuf& src, bool (*end_of_text)(char)) {
 	return make_wstring(read_text(src, end_of_text));
 }
 
-Platform::String^ WarGrey::SCADA::read_wgb18030(std::filebuf& src, bool (*end_of_text)(char)) {
+Platform::String^ WarGrey::SCADA::read_wgb18030(std::streambuf& src, bool (*end_of_text)(char)) {
 	Platform::String^ wstr = nullptr;
 	std::string str;
 	bool gb18030 = false;
@@ -165,7 +165,7 @@ Platform::String^ WarGrey::SCADA::read_wgb18030(std::filebuf& src, bool (*end_of
 	return wstr;
 }
 
-unsigned long long WarGrey::SCADA::read_natural(std::filebuf& src) {
+unsigned long long WarGrey::SCADA::read_natural(std::streambuf& src) {
 	unsigned long long n = 0;
 	char ch;
 
@@ -183,7 +183,7 @@ unsigned long long WarGrey::SCADA::read_natural(std::filebuf& src) {
 	return n;
 }
 
-long long WarGrey::SCADA::read_integer(std::filebuf& src) {
+long long WarGrey::SCADA::read_integer(std::streambuf& src) {
 	long long n = 0;
 	long long sign = 1;
 	char ch;
@@ -210,7 +210,7 @@ long long WarGrey::SCADA::read_integer(std::filebuf& src) {
 	return n * sign;
 }
 
-double WarGrey::SCADA::read_flonum(std::filebuf& src) {
+double WarGrey::SCADA::read_flonum(std::streambuf& src) {
 	double flonum = flnan;
 	double i_acc = 10.0;
 	double f_acc = 1.0;
@@ -262,11 +262,11 @@ double WarGrey::SCADA::read_flonum(std::filebuf& src) {
 	return flonum * sign * ((e == 1) ? 1.0 : flexpt(10.0, double(e)));
 }
 
-float WarGrey::SCADA::read_single_flonum(std::filebuf& src) {
+float WarGrey::SCADA::read_single_flonum(std::streambuf& src) {
 	return float(read_flonum(src));
 }
 
-void WarGrey::SCADA::discard_space(std::filebuf& src) {
+void WarGrey::SCADA::discard_space(std::streambuf& src) {
 	char ch;
 
 	while ((ch = src.sbumpc()) != EOF) {
@@ -277,7 +277,7 @@ void WarGrey::SCADA::discard_space(std::filebuf& src) {
 	}
 }
 
-void WarGrey::SCADA::discard_newline(std::filebuf& src) {
+void WarGrey::SCADA::discard_newline(std::streambuf& src) {
 	char ch;
 	
 	while ((ch = src.sbumpc()) != EOF) {
@@ -288,7 +288,7 @@ void WarGrey::SCADA::discard_newline(std::filebuf& src) {
 	}
 }
 
-void WarGrey::SCADA::discard_this_line(std::filebuf& src) {
+void WarGrey::SCADA::discard_this_line(std::streambuf& src) {
 	char ch;
 
 	while ((ch = src.sbumpc()) != EOF) {
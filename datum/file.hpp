@@ -13,25 +13,25 @@ namespace WarGrey::SCADA {
 	bool char_end_of_line(char ch);
 	bool char_end_of_field(char ch);
 
-	char peek_char(std::filebuf& src);
-	char read_char(std::filebuf& src);
+	char peek_char(std::streambuf& src);
+	char read_char(std::streambuf& src);
 	
-	size_t read_bytes(std::filebuf& src, char* bs, size_t start, size_t end, bool terminating = true);
+	size_t read_bytes(std::streambuf& src, char* bs, size_t start, size_t end, bool terminating = true);
 
-	std::basic_string<unsigned char> read_bytes(std::filebuf& src, bool (*end_of_text)(char) = char_end_of_line);
-	std::string read_text(std::filebuf& src, bool (*end_of_text)(char) = char_end_of_line);
-	Platform::String^ read_wtext(std::filebuf& src, bool (*end_of_text)(char) = char_end_of_line);
-	Platform::String^ read_wgb18030(std::filebuf& src, bool (*end_of_text)(char) = char_end_of_line);
+	std::basic_string<unsigned char> read_bytes(std::streambuf& src, bool (*end_of_text)(char) = char_end_of_line);
+	std::string read_text(std::streambuf& src, bool (*end_of_text)(char) = char_end_of_line);
+	Platform::String^ read_wtext(std::streambuf& src, bool (*end_of_text)(char) = char_end_of_line);
+	Platform::String^ read_wgb18030(std::streambuf& src, bool (*end_of_text)(char) = char_end_of_line);
 
-	bool read_bool(std::filebuf& src);
-	unsigned long long read_natural(std::filebuf& src);
-	long long read_integer(std::filebuf& src);
-	double read_flonum(std::filebuf& src);
-	float read_single_flonum(std::filebuf& src);
+	bool read_bool(std::streambuf& src);
+	unsigned long long read_natural(std::streambuf& src);
+	long long read_integer(std::streambuf& src);
+	double read_flonum(std::streambuf& src);
+	float read_single_flonum(std::streambuf& src);
 
-	void discard_space(std::filebuf& src);
-	void discard_newline(std::filebuf& src);
-	void discard_this_line(std::filebuf& src);
+	void discard_space(std::streambuf& src);
+	void discard_newline(std::streambuf& src);
+	void discard_this_line(std::streambuf& src);
 
 	std::wostream& write_bool(std::wostream& stream, bool b);
 	std::wostream& write_wtext(std::wostream& stream, Platform::String^ text);
@@ -50,7 +50,7 @@ namespace WarGrey::SCADA {
 	}
 
 	template<typename B, size_t N>
-	size_t read_bytes(std::filebuf& src, B (&bs)[N], size_t start = 0, bool terminating = true) {
+	size_t read_bytes(std::streambuf& src, B (&bs)[N], size_t start = 0, bool terminating = true) {
 		return read_bytes(src, (char*)bs, start, N, terminating);
 	}
 }
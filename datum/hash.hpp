@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * 64-bit FNV-1a, feed data in pieces by passing the previous hash as the `seed`.
+	 * It is for digests and bucketing of trusted data, not against adversaries.
+	 */
+	static const unsigned long long fnv1a_offset_basis = 14695981039346656037ULL;
+	static const unsigned long long fnv1a_prime = 1099511628211ULL;
+
+	unsigned long long inline fnv1a_hash(const void* data, size_t size, unsigned long long seed = fnv1a_offset_basis) {
+		const unsigned char* octets = reinterpret_cast<const unsigned char*>(data);
+		unsigned long long hash = seed;
+
+		for (size_t idx = 0; idx < size; idx++) {
+			hash ^= octets[idx];
+			hash *= fnv1a_prime;
+		}
+
+		return hash;
+	}
+}
@@ -1,25 +1,78 @@
 #pragma once
 
+#include <atomic>
+#include <utility>
+
 namespace WarGrey::SCADA {
+	/** NOTE
+	 * The owner who creates the object does not hold a reference implicitly,
+	 *   `destroy()` deletes the object once the last reference (or the only owner) is gone.
+	 *
+	 * Taking references only needs atomicity, while releasing them has to be `acq_rel`,
+	 *   so that all writes through other references happen before the deletion.
+	 */
 	private class SharedObject abstract {
 	public:
-		// TODO: these operations should be locked for thread-safety
 		void reference() {
-			this->refcount++;
+			this->refcount.fetch_add(1, std::memory_order_relaxed);
 		};
 
 		void destroy() {
-			if (this->refcount <= 1) {
+			if (this->refcount.fetch_sub(1, std::memory_order_acq_rel) <= 1) {
 				delete this;
-			} else {
-				this->refcount--;
-			};
+			}
 		}
 
 	protected:
 		virtual ~SharedObject() noexcept {};
 
 	private:
-		int refcount = 0;
-    };
+		std::atomic<int> refcount { 0 };
+	};
+
+	/** NOTE
+	 * An intrusive smart pointer that takes a reference of the `SharedObject` on construction and releases it on destruction,
+	 *   copies are as cheap as an atomic increment, and moves do not touch the refcount at all.
+	 */
+	template<class T>
+	private class SharedReference {
+	public:
+		SharedReference(T* object = nullptr) : object(object) {
+			if (this->object != nullptr) {
+				this->object->reference();
+			}
+		}
+
+		SharedReference(const WarGrey::SCADA::SharedReference<T>& other) : SharedReference(other.object) {}
+
+		SharedReference(WarGrey::SCADA::SharedReference<T>&& other) noexcept : object(other.object) {
+			other.object = nullptr;
+		}
+
+		~SharedReference() noexcept {
+			if (this->object != nullptr) {
+				this->object->destroy();
+			}
+		}
+
+	public:
+		WarGrey::SCADA::SharedReference<T>& operator=(WarGrey::SCADA::SharedReference<T> other) noexcept {
+			std::swap(this->object, other.object);
+
+			return (*this);
+		}
+
+		void reset(T* object = nullptr) {
+			(*this) = WarGrey::SCADA::SharedReference<T>(object);
+		}
+
+	public:
+		T* get() const { return this->object; }
+		T* operator->() const { return this->object; }
+		T& operator*() const { return (*this->object); }
+		explicit operator bool() const { return (this->object != nullptr); }
+
+	private:
+		T* object;
+	};
 }
@@ -115,13 +115,10 @@ Platform::String^ WarGrey::SCADA::file_extension_from_path(Platform::String^ pat
 }
 
 Platform::String^ WarGrey::SCADA::file_basename_from_second(long long timepoint, bool locale) {
-	long long hour, minute, seconds;
+	wchar_t basename[32];
+	size_t size = make_filestamp_utc(basename, sizeof(basename) / sizeof(wchar_t), timepoint, locale);
 
-	// Stupid Windows Machine, ":" cannot be included in filename
-
-	split_time_utc(timepoint, locale, &hour, &minute, &seconds);
-
-	return make_datestamp_utc(timepoint, locale) + "T" + make_wstring(L"%02d_%02d_%02d", hour, minute, seconds);
+	return ref new Platform::String(basename, (unsigned int)size);
 }
 
 Uri^ WarGrey::SCADA::ms_appx_file(Platform::String^ file, Platform::String^ ext, Platform::String^ rootdir) {
@@ -0,0 +1,139 @@
+#include "datum/readahead.hpp"
+
+using namespace WarGrey::SCADA;
+
+/*************************************************************************************************/
+ReadAheadBuffer::ReadAheadBuffer(size_t buffer_size, size_t buffer_count)
+	: buffer_size((buffer_size > 0U) ? buffer_size : 1U), buffer_count((buffer_count > 2U) ? buffer_count : 2U) {
+	// every buffer reserves its first byte for the character put back across buffers
+	this->pool.resize((this->buffer_size + 1U) * this->buffer_count);
+	this->sizes.resize(this->buffer_count);
+}
+
+ReadAheadBuffer::~ReadAheadBuffer() {
+	this->close();
+}
+
+bool ReadAheadBuffer::open(Platform::String^ in_port) {
+	this->close();
+
+	if (this->src.open(in_port->Data(), std::ios::in | std::ios::binary) != nullptr) {
+		this->filled_count = 0;
+		this->head = 0;
+		this->holding = false;
+		this->eof = false;
+		this->stopping = false;
+
+		this->setg(nullptr, nullptr, nullptr);
+		this->io = std::thread([this]() { this->read_ahead(); });
+	}
+
+	return this->is_open();
+}
+
+bool ReadAheadBuffer::is_open() {
+	return this->src.is_open();
+}
+
+void ReadAheadBuffer::close() {
+	if (this->io.joinable()) {
+		this->section.lock();
+		this->stopping = true;
+		this->section.unlock();
+
+		this->consumed_signal.notify_all();
+		this->io.join();
+	}
+
+	if (this->src.is_open()) {
+		this->src.close();
+	}
+
+	this->setg(nullptr, nullptr, nullptr);
+}
+
+std::streambuf::int_type ReadAheadBuffer::underflow() {
+	std::unique_lock<std::mutex> guard(this->section);
+	char putback = '\0';
+	bool has_putback = false;
+
+	if (this->holding) {
+		if (this->gptr() > this->eback()) {
+			putback = this->gptr()[-1];
+			has_putback = true;
+		}
+
+		this->holding = false;
+		this->head = (this->head + 1U) % this->buffer_count;
+		this->filled_count--;
+		this->consumed_signal.notify_one();
+	}
+
+	this->filled_signal.wait(guard, [this]() { return (this->filled_count > 0U) || this->eof; });
+
+	if (this->filled_count == 0U) {
+		this->setg(nullptr, nullptr, nullptr);
+
+		return traits_type::eof();
+	}
+
+	{ // hold the next buffer
+		char* buffer = this->buffer_ref(this->head);
+		char* start = buffer + 1;
+
+		this->holding = true;
+
+		if (has_putback) {
+			buffer[0] = putback;
+			this->setg(buffer, start, start + this->sizes[this->head]);
+		} else {
+			this->setg(start, start, start + this->sizes[this->head]);
+		}
+	}
+
+	return traits_type::to_int_type(*this->gptr());
+}
+
+/*************************************************************************************************/
+void ReadAheadBuffer::read_ahead() {
+	size_t tail = 0U;
+
+	while (true) {
+		std::streamsize size = 0;
+
+		{ // wait for a free buffer
+			std::unique_lock<std::mutex> guard(this->section);
+
+			this->consumed_signal.wait(guard, [this]() { return (this->filled_count < this->buffer_count) || this->stopping; });
+
+			if (this->stopping) {
+				break;
+			}
+		}
+
+		// the buffer at `tail` is neither filled nor held, no lock is needed while reading
+		size = this->src.sgetn(this->buffer_ref(tail) + 1, std::streamsize(this->buffer_size));
+
+		{ // publish it
+			std::unique_lock<std::mutex> guard(this->section);
+
+			if (size > 0) {
+				this->sizes[tail] = size_t(size);
+				this->filled_count++;
+				tail = (tail + 1U) % this->buffer_count;
+			} else {
+				this->eof = true;
+			}
+		}
+
+		this->filled_signal.notify_one();
+
+		if (size <= 0) {
+			break;
+		}
+	}
+}
+
+char* ReadAheadBuffer::buffer_ref(size_t idx) {
+	return this->pool.data() + (this->buffer_size + 1U) * idx;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * The `std::filebuf` refills its buffer synchronously, hence the parser and the disk wait for each other.
+	 * This buffer keeps a background thread filling the next buffers while the parser consumes the current one,
+	 *   and it can be passed to all `read_*` and `discard_*` functions declared in "datum/file.hpp".
+	 *
+	 * Only one character can be put back after crossing a buffer boundary,
+	 *   which is exactly what the `read_*` functions need.
+	 */
+	private class ReadAheadBuffer : public std::streambuf {
+	public:
+		virtual ~ReadAheadBuffer() noexcept;
+		ReadAheadBuffer(size_t buffer_size = 64U * 1024U, size_t buffer_count = 2U);
+
+	public:
+		bool open(Platform::String^ in_port);
+		bool is_open();
+		void close();
+
+	protected:
+		std::streambuf::int_type underflow() override;
+
+	private:
+		void read_ahead();
+		char* buffer_ref(size_t idx);
+
+	private:
+		std::filebuf src;
+		std::thread io;
+		std::mutex section;
+		std::condition_variable filled_signal;
+		std::condition_variable consumed_signal;
+
+	private:
+		std::vector<char> pool;
+		std::vector<size_t> sizes;
+		size_t buffer_size;
+		size_t buffer_count;
+		size_t filled_count = 0;
+		size_t head = 0;
+		bool holding = false;
+		bool eof = false;
+		bool stopping = false;
+	};
+}
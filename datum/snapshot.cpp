@@ -0,0 +1,230 @@
+#include <cstring>
+#include <Windows.h>
+
+#include "datum/snapshot.hpp"
+#include "datum/path.hpp"
+#include "datum/hash.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+static const char snapshot_magic[4] = { 'W', 'G', 'S', 'S' };
+static const unsigned int snapshot_format_version = 1U;
+static const long long mtime_granularity = 20000000LL; // 2s in 100ns, the coarsest one (FAT)
+
+/** WARNING
+ * Records are dumped in native byte order and layout,
+ *   bump the schema whenever the record type changes.
+ */
+struct SnapshotHeader {
+	char magic[4];
+	uint32 format_version;
+	uint32 schema;
+	uint32 record_size;
+	uint64 record_count;
+	uint64 source_size;
+	int64 source_mtime;
+	uint64 source_hash;
+	uint64 payload_offset;
+	uint8 reserved[8];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "the snapshot header should be 64 bytes");
+
+static unsigned long long file_fnv1a_hash(Platform::String^ path) {
+	unsigned long long hash = fnv1a_offset_basis;
+	std::filebuf src;
+	char pool[64 * 1024];
+	std::streamsize size;
+
+	if (open_input_binary(src, path)) {
+		while ((size = src.sgetn(pool, sizeof(pool))) > 0) {
+			hash = fnv1a_hash(pool, size_t(size), hash);
+		}
+	}
+
+	return hash;
+}
+
+/*************************************************************************************************/
+bool WarGrey::SCADA::snapshot_source_stamp(Platform::String^ source, SnapshotStamp* stamp, bool with_hash) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	bool okay = (GetFileAttributesExW(source->Data(), GetFileExInfoStandard, &attributes) != FALSE);
+
+	if (okay) {
+		stamp->size = ((unsigned long long)(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		stamp->mtime = ((long long)(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+		stamp->hash = (with_hash ? file_fnv1a_hash(source) : 0ULL);
+	}
+
+	return okay;
+}
+
+Platform::String^ WarGrey::SCADA::snapshot_default_path(Platform::String^ source) {
+	StorageFolder^ cache = ApplicationData::Current->LocalCacheFolder;
+
+	return cache->Path + "\\" + file_name_from_path(source) + ".snapshot";
+}
+
+bool WarGrey::SCADA::write_binary_snapshot(Platform::String^ snapshot, SnapshotStamp& stamp
+	, unsigned int schema, const void* records, size_t record_size, size_t count) {
+	Platform::String^ tmpfile = snapshot + ".tmp";
+	std::streamsize payload_size = std::streamsize(record_size * count);
+	std::filebuf dest;
+	SnapshotHeader header;
+	bool okay = false;
+
+	memset(&header, 0, sizeof(SnapshotHeader));
+	memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+	header.format_version = snapshot_format_version;
+	header.schema = schema;
+	header.record_size = uint32(record_size);
+	header.record_count = count;
+	header.source_size = stamp.size;
+	header.source_mtime = stamp.mtime;
+	header.source_hash = stamp.hash;
+	header.payload_offset = sizeof(SnapshotHeader);
+
+	// write into a temporary file first, readers should never map a half-done snapshot
+	if (dest.open(tmpfile->Data(), std::ios::out | std::ios::binary | std::ios::trunc) != nullptr) {
+		okay = (dest.sputn((const char*)(&header), sizeof(SnapshotHeader)) == sizeof(SnapshotHeader));
+
+		if (okay && (payload_size > 0)) {
+			okay = (dest.sputn((const char*)(records), payload_size) == payload_size);
+		}
+
+		okay = ((dest.close() != nullptr) && okay);
+	}
+
+	if (okay) {
+		okay = (MoveFileExW(tmpfile->Data(), snapshot->Data(), MOVEFILE_REPLACE_EXISTING) != FALSE);
+	}
+
+	if (!okay) {
+		DeleteFileW(tmpfile->Data());
+	}
+
+	return okay;
+}
+
+/*************************************************************************************************/
+BinarySnapshot::~BinarySnapshot() {
+	this->unmap();
+}
+
+bool BinarySnapshot::map(Platform::String^ snapshot, Platform::String^ source, unsigned int schema, size_t record_size, bool verify_hash) {
+	SnapshotStamp stamp;
+	LARGE_INTEGER file_size;
+	FILETIME written;
+	long long snapshot_mtime = 0LL;
+	HANDLE file, mapping;
+	const SnapshotHeader* header = nullptr;
+	bool okay = false;
+
+	this->unmap();
+
+	if (snapshot_source_stamp(source, &stamp, false)) {
+		file = CreateFile2(snapshot->Data(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+
+		if (file != INVALID_HANDLE_VALUE) {
+			this->file = file;
+
+			if (GetFileTime(file, nullptr, nullptr, &written)) {
+				snapshot_mtime = ((long long)(written.dwHighDateTime) << 32) | written.dwLowDateTime;
+			}
+
+			if (GetFileSizeEx(file, &file_size) && (file_size.QuadPart >= LONGLONG(sizeof(SnapshotHeader)))) {
+				mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+
+				if (mapping != nullptr) {
+					this->mapping = mapping;
+					this->view = (const unsigned char*)MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+				}
+			}
+		}
+	}
+
+	if (this->view != nullptr) {
+		header = reinterpret_cast<const SnapshotHeader*>(this->view);
+
+		okay = ((memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) == 0)
+			&& (header->format_version == snapshot_format_version)
+			&& (header->schema == schema)
+			&& (header->record_size == record_size) && (record_size > 0)
+			&& (header->source_size == stamp.size)
+			&& (header->source_mtime == stamp.mtime)
+			&& (header->payload_offset <= (unsigned long long)(file_size.QuadPart))
+			&& (header->record_count <= ((unsigned long long)(file_size.QuadPart) - header->payload_offset) / record_size));
+
+		// the source might be modified again within the same tick of its mtime after the snapshot was taken
+		if (okay && (!verify_hash)) {
+			verify_hash = (snapshot_mtime - stamp.mtime < mtime_granularity);
+		}
+
+		if (okay && verify_hash) {
+			okay = (header->source_hash == file_fnv1a_hash(source));
+		}
+	}
+
+	if (okay) {
+		this->record_count = size_t(header->record_count);
+		this->payload_offset = size_t(header->payload_offset);
+	} else {
+		this->unmap();
+	}
+
+	return okay;
+}
+
+void BinarySnapshot::unmap() {
+	if (this->view != nullptr) {
+		UnmapViewOfFile(this->view);
+		this->view = nullptr;
+	}
+
+	if (this->mapping != nullptr) {
+		CloseHandle(this->mapping);
+		this->mapping = nullptr;
+	}
+
+	if (this->file != nullptr) {
+		CloseHandle(this->file);
+		this->file = nullptr;
+	}
+
+	this->record_count = 0;
+	this->payload_offset = 0;
+	this->fallback.clear();
+}
+
+bool BinarySnapshot::mapped() {
+	return (this->view != nullptr);
+}
+
+void BinarySnapshot::adopt(const void* records, size_t record_size, size_t count) {
+	const unsigned char* src = reinterpret_cast<const unsigned char*>(records);
+
+	this->unmap();
+
+	if (count > 0) {
+		this->fallback.assign(src, src + record_size * count);
+		this->record_count = count;
+	}
+}
+
+size_t BinarySnapshot::count() {
+	return this->record_count;
+}
+
+const void* BinarySnapshot::records() {
+	const void* records = nullptr;
+
+	if (this->view != nullptr) {
+		records = this->view + this->payload_offset;
+	} else if (!this->fallback.empty()) {
+		records = this->fallback.data();
+	}
+
+	return records;
+}
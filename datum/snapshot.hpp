@@ -0,0 +1,119 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+#include <type_traits>
+
+#include "datum/file.hpp"
+#include "datum/readahead.hpp"
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * A snapshot is the parsed records of a text file dumped as is,
+	 *   so that the next launch maps the records instead of parsing the text again.
+	 *
+	 * The snapshot is keyed by the size, the last write time and the FNV-1a hash of its source,
+	 *   the hash is only checked on demand since computing it costs a full read of the source,
+	 *   or if the snapshot was taken within the granularity of the last write time of its source.
+	 *
+	 * If the snapshot cannot be written or mapped, the parsed records are kept in memory instead.
+	 */
+
+	private struct SnapshotStamp {
+		unsigned long long size;
+		long long mtime;
+		unsigned long long hash;
+	};
+
+	bool snapshot_source_stamp(Platform::String^ source, WarGrey::SCADA::SnapshotStamp* stamp, bool with_hash = false);
+	Platform::String^ snapshot_default_path(Platform::String^ source);
+
+	bool write_binary_snapshot(Platform::String^ snapshot, WarGrey::SCADA::SnapshotStamp& stamp,
+		unsigned int schema, const void* records, size_t record_size, size_t count);
+
+	private class BinarySnapshot {
+	public:
+		virtual ~BinarySnapshot() noexcept;
+		BinarySnapshot() {}
+
+	public:
+		bool map(Platform::String^ snapshot, Platform::String^ source,
+			unsigned int schema, size_t record_size, bool verify_hash = false);
+
+		void unmap();
+		bool mapped();
+
+		void adopt(const void* records, size_t record_size, size_t count);
+
+	public:
+		size_t count();
+		const void* records();
+
+		template<typename R>
+		const R* records() {
+			return reinterpret_cast<const R*>(this->records());
+		}
+
+	private:
+		void* file = nullptr;
+		void* mapping = nullptr;
+		const unsigned char* view = nullptr;
+		size_t record_count = 0;
+		size_t payload_offset = 0;
+		std::vector<unsigned char> fallback;
+	};
+
+	/************************************************************************************************/
+	template<typename R>
+	bool convert_to_binary_snapshot(Platform::String^ source, Platform::String^ snapshot, unsigned int schema,
+		void (*parse)(std::streambuf&, std::vector<R>&), std::vector<R>& records) {
+		static_assert(std::is_trivially_copyable<R>::value, "snapshot records must be plain data");
+
+		ReadAheadBuffer src;
+		SnapshotStamp stamp;
+		bool okay = false;
+
+		if (snapshot_source_stamp(source, &stamp, true)) {
+			if (src.open(source)) {
+				parse(src, records);
+				src.close();
+
+				okay = write_binary_snapshot(snapshot, stamp, schema, records.data(), sizeof(R), records.size());
+			}
+		}
+
+		return okay;
+	}
+
+	template<typename R>
+	bool convert_to_binary_snapshot(Platform::String^ source, Platform::String^ snapshot, unsigned int schema,
+		void (*parse)(std::streambuf&, std::vector<R>&)) {
+		std::vector<R> records;
+
+		return convert_to_binary_snapshot(source, snapshot, schema, parse, records);
+	}
+
+	template<typename R>
+	const R* load_binary_snapshot(WarGrey::SCADA::BinarySnapshot& self, Platform::String^ source, unsigned int schema,
+		void (*parse)(std::streambuf&, std::vector<R>&), size_t* count = nullptr, Platform::String^ snapshot = nullptr
+		, bool verify_hash = false) {
+		if (snapshot == nullptr) {
+			snapshot = snapshot_default_path(source);
+		}
+
+		if (!self.map(snapshot, source, schema, sizeof(R), verify_hash)) {
+			std::vector<R> parsed;
+
+			if (!convert_to_binary_snapshot(source, snapshot, schema, parse, parsed)
+				|| !self.map(snapshot, source, schema, sizeof(R), verify_hash)) {
+				self.adopt(parsed.data(), sizeof(R), parsed.size());
+			}
+		}
+
+		if (count != nullptr) {
+			(*count) = self.count();
+		}
+
+		return self.records<R>();
+	}
+}
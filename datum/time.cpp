@@ -4,6 +4,7 @@
 #include <thread>
 #include <Windows.h>
 #include <timezoneapi.h>
+#include <intrin.h>
 
 #include "datum/fixnum.hpp"
 #include "datum/time.hpp"
@@ -19,18 +20,175 @@ static const long long l00ns_s = l00ns_ms * 1000LL;
 static const long long ms_1601_1970 = 11644473600000LL;
 static const long long l00ns_1601_1970 = ms_1601_1970 * l00ns_ms;
 
-static inline void wtime(wchar_t* timestamp, time_t utc_s, const wchar_t* tfmt, bool locale = false) {
-	struct tm now_s;
-
-	if (locale) {
-		localtime_s(&now_s, &utc_s);
+static const long long tz_first_year = 1970LL;
+static const long long tz_last_year = 2099LL;
+
+namespace {
+	/** NOTE
+	 * Transitions are resolved for every year once, so that the historical DST rules are also respected,
+	 *   the bias follows the convention of Windows: UTC = local time + bias.
+	 *
+	 * WARNING: changing the time zone while the application is running takes effect after restarting.
+	 */
+	struct TimeZoneRule {
+		long long bias;
+		long long standard_bias;
+		long long daylight_bias;
+		long long daylight_start;
+		long long daylight_end;
+		bool has_daylight;
+	};
+
+	struct TimeZoneRules {
+		TimeZoneRules();
+
+		TimeZoneRule years[tz_last_year - tz_first_year + 1LL];
+	};
+}
+
+static long long transition_local_seconds(const SYSTEMTIME& rule, long long year) {
+	long long days = 0LL;
+
+	if (rule.wYear == 0) { // the wDay-th (5 means the last) wDayOfWeek of wMonth
+		long long first = days_from_civil(year, rule.wMonth, 1);
+		long long mday = 1LL + civil_floor_mod(rule.wDayOfWeek - civil_weekday(first), 7) + (rule.wDay - 1LL) * 7LL;
+		long long mdays = civil_days_in_month(year, rule.wMonth);
+
+		while (mday > mdays) {
+			mday -= 7LL;
+		}
+
+		days = first + mday - 1LL;
 	} else {
-		gmtime_s(&now_s, &utc_s);
+		days = days_from_civil(year, rule.wMonth, rule.wDay);
+	}
+
+	return days * day_span_s + rule.wHour * hour_span_s + rule.wMinute * minute_span_s + rule.wSecond;
+}
+
+TimeZoneRules::TimeZoneRules() {
+	for (long long year = tz_first_year; year <= tz_last_year; year++) {
+		TimeZoneRule* self = &this->years[year - tz_first_year];
+		TIME_ZONE_INFORMATION tz;
+
+		if (!GetTimeZoneInformationForYear(USHORT(year), nullptr, &tz)) {
+			GetTimeZoneInformation(&tz);
+		}
+
+		self->bias = tz.Bias * minute_span_s;
+		self->standard_bias = tz.StandardBias * minute_span_s;
+		self->daylight_bias = tz.DaylightBias * minute_span_s;
+		self->has_daylight = ((tz.DaylightDate.wMonth != 0) && (tz.StandardDate.wMonth != 0));
+
+		if (self->has_daylight) {
+			self->daylight_start = transition_local_seconds(tz.DaylightDate, year) + self->bias + self->standard_bias;
+			self->daylight_end = transition_local_seconds(tz.StandardDate, year) + self->bias + self->daylight_bias;
+		} else {
+			self->daylight_start = 0LL;
+			self->daylight_end = 0LL;
+		}
+	}
+}
+
+static const TimeZoneRule* time_zone_rule(long long utc_s) {
+	static const TimeZoneRules rules;
+	long long year = 0LL;
+
+	civil_from_days(civil_floor_div(utc_s, day_span_s), &year, nullptr, nullptr);
+
+	if (year < tz_first_year) {
+		year = tz_first_year;
+	} else if (year > tz_last_year) {
+		year = tz_last_year;
 	}
 
+	return &rules.years[year - tz_first_year];
+}
+
+static inline bool time_zone_daylight(const TimeZoneRule* rule, long long utc_s) {
+	bool daylight = false;
+
+	if (rule->has_daylight) {
+		if (rule->daylight_start < rule->daylight_end) {
+			daylight = ((utc_s >= rule->daylight_start) && (utc_s < rule->daylight_end));
+		} else { // southern hemisphere
+			daylight = ((utc_s >= rule->daylight_start) || (utc_s < rule->daylight_end));
+		}
+	}
+
+	return daylight;
+}
+
+static inline void civil_time(struct tm* datetime, long long utc_s, bool locale) {
+	bool dst = false;
+	long long s = (locale ? utc_to_local_seconds(utc_s, &dst) : utc_s);
+	long long days = civil_floor_div(s, day_span_s);
+	long long daytime = s - days * day_span_s;
+	long long year, month, day;
+
+	civil_from_days(days, &year, &month, &day);
+
+	datetime->tm_year = int(year - 1900LL);
+	datetime->tm_mon = int(month - 1LL);
+	datetime->tm_mday = int(day);
+	datetime->tm_hour = int(daytime / hour_span_s);
+	datetime->tm_min = int(daytime % hour_span_s / minute_span_s);
+	datetime->tm_sec = int(daytime % minute_span_s);
+	datetime->tm_wday = int(civil_weekday(days));
+	datetime->tm_yday = int(days - days_from_civil(year, 1, 1));
+	datetime->tm_isdst = (dst ? 1 : 0);
+}
+
+static inline void wtime(wchar_t* timestamp, long long utc_s, const wchar_t* tfmt, bool locale = false) {
+	struct tm now_s;
+
+	civil_time(&now_s, utc_s, locale);
 	wcsftime(timestamp, 31, tfmt, &now_s);
 }
 
+static inline long long civil_add_months(long long s, long long months) {
+	long long days = civil_floor_div(s, day_span_s);
+	long long daytime = s - days * day_span_s;
+	long long year, month, day;
+
+	civil_from_days(days, &year, &month, &day);
+
+	month += months - 1LL;
+	year += civil_floor_div(month, 12LL);
+	month = civil_floor_mod(month, 12LL) + 1LL;
+
+	// overflowed days roll into the next month, as `_mkgmtime` does
+	return (days_from_civil(year, month, 1) + day - 1LL) * day_span_s + daytime;
+}
+
+namespace {
+	struct TimestampCache {
+		long long second = -1LL;
+		bool locale = false;
+		wchar_t prefix[32];
+		size_t length = 0U;
+	};
+}
+
+static size_t fill_cached_stamp(TimestampCache& cache, wchar_t* dest, size_t size, long long utc_s, bool locale, const wchar_t* tfmt) {
+	size_t length = 0U;
+
+	if ((cache.second != utc_s) || (cache.locale != locale)) {
+		wtime(cache.prefix, utc_s, tfmt, locale);
+		cache.length = wcslen(cache.prefix);
+		cache.second = utc_s;
+		cache.locale = locale;
+	}
+
+	if (size > 0U) {
+		length = ((cache.length < size) ? cache.length : (size - 1U));
+		wmemcpy(dest, cache.prefix, length);
+		dest[length] = L'\0';
+	}
+
+	return length;
+}
+
 static inline long long current_hectonanoseconds() {
 	// Stupid Windows Machine
 	FILETIME l00ns_1601;
@@ -42,6 +200,56 @@ static inline long long current_hectonanoseconds() {
 	return l00ns_1970 - l00ns_1601_1970;
 }
 
+static long long query_performance_frequency() {
+	LARGE_INTEGER hz;
+
+	QueryPerformanceFrequency(&hz); // never fails since Windows XP, and it is fixed at boot
+
+	return hz.QuadPart;
+}
+
+static inline long long performance_frequency() {
+	static const long long frequency = query_performance_frequency();
+
+	return frequency;
+}
+
+static inline long long performance_counter() {
+	LARGE_INTEGER counter;
+
+	QueryPerformanceCounter(&counter);
+
+	return counter.QuadPart;
+}
+
+static inline unsigned long long read_tsc() {
+#if defined(_M_X64) || defined(_M_IX86)
+	return __rdtsc();
+#else
+	return (unsigned long long)(performance_counter());
+#endif
+}
+
+static double calibrate_tsc_ticks_per_ms() {
+#if defined(_M_X64) || defined(_M_IX86)
+	long long hz = performance_frequency();
+	long long qpc0 = performance_counter();
+	unsigned long long tsc0 = read_tsc();
+	long long qpc1 = qpc0;
+	unsigned long long tsc1 = tsc0;
+
+	// about 5ms, the invariant TSC of modern processors does not change its rate afterwards
+	while ((qpc1 - qpc0) < (hz / 200LL)) {
+		qpc1 = performance_counter();
+		tsc1 = read_tsc();
+	}
+
+	return double(tsc1 - tsc0) * double(hz) / double(qpc1 - qpc0) / 1000.0;
+#else
+	return double(performance_frequency()) / 1000.0;
+#endif
+}
+
 /**************************************************************************************************/
 long long WarGrey::SCADA::floor_seconds(long long the_100ns, long long span) {
 	long long the_second = the_100ns / l00ns_s;
@@ -58,11 +266,27 @@ long long WarGrey::SCADA::ceiling_seconds(long long the_100ns, long long span) {
 }
 
 long long WarGrey::SCADA::time_zone_utc_bias_seconds() {
-	TIME_ZONE_INFORMATION tz;
+	return time_zone_rule(current_seconds())->bias;
+}
 
-	GetTimeZoneInformation(&tz);
+long long WarGrey::SCADA::utc_to_local_seconds(long long utc_s, bool* dst) {
+	const TimeZoneRule* rule = time_zone_rule(utc_s);
+	bool daylight = time_zone_daylight(rule, utc_s);
+
+	SET_BOX(dst, daylight);
+
+	return utc_s - rule->bias - (daylight ? rule->daylight_bias : rule->standard_bias);
+}
+
+long long WarGrey::SCADA::local_to_utc_seconds(long long local_s) {
+	const TimeZoneRule* rule = time_zone_rule(local_s);
+	long long utc_s = local_s + rule->bias + rule->standard_bias;
+
+	if (time_zone_daylight(rule, utc_s)) {
+		utc_s = local_s + rule->bias + rule->daylight_bias;
+	}
 
-	return tz.Bias * minute_span_s;
+	return utc_s;
 }
 
 /**************************************************************************************************/
@@ -90,6 +314,43 @@ double WarGrey::SCADA::current_inexact_seconds() {
 	return double(l00ns / l00ns_s) + double(l00ns % l00ns_s) / double(l00ns_s);
 }
 
+/**************************************************************************************************/
+long long WarGrey::SCADA::current_monotonic_100nanoseconds() {
+	long long hz = performance_frequency();
+	long long counter = performance_counter();
+
+	// split the conversion to avoid overflowing
+	return (counter / hz) * l00ns_s + (counter % hz) * l00ns_s / hz;
+}
+
+long long WarGrey::SCADA::current_monotonic_microseconds() {
+	return current_monotonic_100nanoseconds() / l00ns_us;
+}
+
+long long WarGrey::SCADA::current_monotonic_milliseconds() {
+	return current_monotonic_100nanoseconds() / l00ns_ms;
+}
+
+double WarGrey::SCADA::current_monotonic_inexact_milliseconds() {
+	long long l00ns = current_monotonic_100nanoseconds();
+
+	return double(l00ns / l00ns_ms) + double(l00ns % l00ns_ms) / double(l00ns_ms);
+}
+
+long long WarGrey::SCADA::current_coarse_monotonic_milliseconds() {
+	return (long long)(GetTickCount64());
+}
+
+unsigned long long WarGrey::SCADA::current_tsc_ticks() {
+	return read_tsc();
+}
+
+double WarGrey::SCADA::tsc_ticks_to_inexact_milliseconds(unsigned long long ticks) {
+	static const double ticks_per_ms = calibrate_tsc_ticks_per_ms();
+
+	return double(ticks) / ticks_per_ms;
+}
+
 /**************************************************************************************************/
 int WarGrey::SCADA::current_year() {
 	long long year;
@@ -146,21 +407,13 @@ void WarGrey::SCADA::sleep_us(long long us) {
 
 /*************************************************************************************************/
 void WarGrey::SCADA::split_date_utc(long long s, bool locale, long long* year, long long* month, long long* day) {
-	struct tm datetime;
+	long long t = (locale ? utc_to_local_seconds(s) : s);
 
-	if (locale) {
-		localtime_s(&datetime, &s);
-	} else {
-		gmtime_s(&datetime, &s);
-	}
-
-	SET_BOX(year, datetime.tm_year + 1900);
-	SET_BOX(month, datetime.tm_mon + 1);
-	SET_BOX(day, datetime.tm_mday);
+	civil_from_days(civil_floor_div(t, day_span_s), year, month, day);
 }
 
 void WarGrey::SCADA::split_time_utc(long long s, bool locale, long long* hours, long long* minutes, long long* seconds) {
-	long long daytime = (locale ? (s - time_zone_utc_bias_seconds()) : s) % day_span_s;
+	long long daytime = civil_floor_mod((locale ? utc_to_local_seconds(s) : s), day_span_s);
 	
 	SET_BOX(hours, daytime / hour_span_s);
 	SET_BOX(minutes, daytime % hour_span_s / minute_span_s);
@@ -168,20 +421,9 @@ void WarGrey::SCADA::split_time_utc(long long s, bool locale, long long* hours,
 }
 
 long long WarGrey::SCADA::make_seconds(long long year, long long month, long long day, bool locale) {
-	time_t rawtime = current_seconds();
-	struct tm datetime;
-
-	gmtime_s(&datetime, &rawtime);
+	long long t = civil_add_months(days_from_civil(year, 1, 1) * day_span_s, month - 1LL) + (day - 1LL) * day_span_s;
 
-	datetime.tm_hour = 0;
-	datetime.tm_min = 0;
-	datetime.tm_sec = 0;
-
-	datetime.tm_year = int(year - 1900);
-	datetime.tm_mon = int(month - 1);
-	datetime.tm_mday = int(day);
-
-	return mktime(&datetime) - (locale ? 0L : time_zone_utc_bias_seconds());
+	return (locale ? local_to_utc_seconds(t) : t);
 }
 
 long long WarGrey::SCADA::seconds_add_seconds(long long s, long long count) {
@@ -201,21 +443,11 @@ long long WarGrey::SCADA::seconds_add_days(long long s, long long count) {
 }
 
 long long WarGrey::SCADA::seconds_add_months(long long s, long long count) {
-	struct tm datetime;
-
-	gmtime_s(&datetime, &s);
-	datetime.tm_mon += int(count);
-
-	return _mkgmtime(&datetime);
+	return civil_add_months(s, count);
 }
 
 long long WarGrey::SCADA::seconds_add_years(long long s, long long count) {
-	struct tm datetime;
-
-	gmtime_s(&datetime, &s);	
-	datetime.tm_year += int(count);
-
-	return _mkgmtime(&datetime);
+	return civil_add_months(s, count * 12LL);
 }
 
 /*************************************************************************************************/
@@ -244,18 +476,41 @@ Platform::String^ WarGrey::SCADA::make_daytimestamp_utc(long long utc_s, bool lo
 }
 
 Platform::String^ WarGrey::SCADA::update_nowstamp(bool need_us, int* l00ns) {
+	wchar_t timestamp[40];
+	size_t size = update_nowstamp(timestamp, sizeof(timestamp) / sizeof(wchar_t), need_us, l00ns);
+
+	return ref new Platform::String(timestamp, (unsigned int)size);
+}
+
+size_t WarGrey::SCADA::update_nowstamp(wchar_t* timestamp, size_t size, bool need_us, int* l00ns) {
+	static thread_local TimestampCache cache;
 	long long hecto_ns = current_hectonanoseconds();
-	long long us = hecto_ns / 10L;
-	Platform::String^ ts = make_timestamp_utc(hecto_ns / l00ns_s, true);
+	size_t length = fill_cached_stamp(cache, timestamp, size, hecto_ns / l00ns_s, true, L"%FT%T");
 	
-	if (need_us) {
-		ts += ".";
-		ts += (us % 1000000LL).ToString();
+	if (need_us && (length + 7U < size)) {
+		long long us = (hecto_ns % l00ns_s) / l00ns_us;
+
+		timestamp[length++] = L'.';
+
+		for (size_t digit = 6U; digit > 0U; digit--) { // zero-padded
+			timestamp[length + digit - 1U] = wchar_t(L'0' + us % 10LL);
+			us /= 10LL;
+		}
+
+		length += 6U;
+		timestamp[length] = L'\0';
 	}
 
 	if (l00ns != nullptr) {
-		(*l00ns) = hecto_ns % l00ns_s;
+		(*l00ns) = int(hecto_ns % l00ns_s);
 	}
 
-	return ts;
+	return length;
+}
+
+size_t WarGrey::SCADA::make_filestamp_utc(wchar_t* filestamp, size_t size, long long utc_s, bool locale) {
+	static thread_local TimestampCache cache;
+
+	// Stupid Windows Machine, ":" cannot be included in filename
+	return fill_cached_stamp(cache, filestamp, size, utc_s, locale, L"%FT%H_%M_%S");
 }
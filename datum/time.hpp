@@ -5,6 +5,58 @@ namespace WarGrey::SCADA {
 	static const long long hour_span_s = 60LL * minute_span_s;
 	static const long long day_span_s = 24LL * hour_span_s;
 
+	/** NOTE
+	 * Pure arithmetic on the proleptic Gregorian calendar (Howard Hinnant's algorithms),
+	 *   days are counted from 1970-01-01, and weekdays are counted from Sunday.
+	 */
+	constexpr long long civil_floor_div(long long n, long long d) {
+		return ((n >= 0) ? (n / d) : (-((-n + d - 1) / d)));
+	}
+
+	constexpr long long civil_floor_mod(long long n, long long d) {
+		return n - civil_floor_div(n, d) * d;
+	}
+
+	constexpr bool civil_leap_year(long long y) {
+		return ((y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0)));
+	}
+
+	constexpr long long civil_days_in_month(long long y, long long m) {
+		return ((m == 2) ? (civil_leap_year(y) ? 29 : 28) : (((m == 4) || (m == 6) || (m == 9) || (m == 11)) ? 30 : 31));
+	}
+
+	constexpr long long days_from_civil(long long y, long long m, long long d) {
+		long long yy = y - ((m <= 2) ? 1 : 0);
+		long long era = civil_floor_div(yy, 400);
+		long long yoe = yy - era * 400;
+		long long doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + d - 1;
+		long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+		return era * 146097 + doe - 719468;
+	}
+
+	constexpr void civil_from_days(long long days, long long* year, long long* month, long long* day) {
+		long long z = days + 719468;
+		long long era = civil_floor_div(z, 146097);
+		long long doe = z - era * 146097;
+		long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		long long mp = (5 * doy + 2) / 153;
+		long long m = mp + ((mp < 10) ? 3 : -9);
+
+		if (year != nullptr) (*year) = yoe + era * 400 + ((m <= 2) ? 1 : 0);
+		if (month != nullptr) (*month) = m;
+		if (day != nullptr) (*day) = doy - (153 * mp + 2) / 5 + 1;
+	}
+
+	constexpr long long civil_weekday(long long days) {
+		return civil_floor_mod(days + 4, 7);
+	}
+
+	long long utc_to_local_seconds(long long utc_s, bool* dst = nullptr);
+	long long local_to_utc_seconds(long long local_s);
+
+	/*********************************************************************************************/
 	Windows::Foundation::TimeSpan make_timespan_from_milliseconds(long long ms);
 	Windows::Foundation::TimeSpan make_timespan_from_seconds(long long s);
 	Windows::Foundation::TimeSpan make_timespan_from_rate(int rate, unsigned int shift = 1U);
@@ -24,6 +76,22 @@ namespace WarGrey::SCADA {
 	long long current_floor_seconds(long long span_s = day_span_s);
 	long long current_ceiling_seconds(long long span_s = day_span_s);
 
+	/** NOTE
+	 * The `current_*` functions above read the wall clock, which might be adjusted at any time,
+	 *   use the monotonic ones below to measure spans, timeouts and heartbeats.
+	 *
+	 * The coarse one is as cheap as reading a variable, but it only ticks every 10-16ms;
+	 * The TSC one is the cheapest fine-grained clock for hot paths, convert the difference of two readings.
+	 */
+	long long current_monotonic_100nanoseconds();
+	long long current_monotonic_microseconds();
+	long long current_monotonic_milliseconds();
+	double current_monotonic_inexact_milliseconds();
+	long long current_coarse_monotonic_milliseconds();
+
+	unsigned long long current_tsc_ticks();
+	double tsc_ticks_to_inexact_milliseconds(unsigned long long ticks);
+
 	void split_date_utc(long long s, bool locale, long long* year, long long* month, long long* day);
 	void split_time_utc(long long s, bool locale, long long* hours, long long* minutes, long long* seconds);
 	
@@ -43,4 +111,11 @@ namespace WarGrey::SCADA {
 	Platform::String^ make_daytimestamp_utc(long long utc_s, bool locale);
 
 	Platform::String^ update_nowstamp(bool need_us = true, int* l00ns = nullptr);
+
+	/** NOTE
+	 * These two cache the formatted date-time per second and per thread,
+	 *   they write into the caller's buffer and return the number of characters written.
+	 */
+	size_t update_nowstamp(wchar_t* timestamp, size_t size, bool need_us = true, int* l00ns = nullptr);
+	size_t make_filestamp_utc(wchar_t* filestamp, size_t size, long long utc_s, bool locale = true);
 }
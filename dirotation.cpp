@@ -13,64 +13,63 @@ using namespace WarGrey::SCADA;
 using namespace Concurrency;
 
 using namespace Windows::Foundation;
-using namespace Windows::UI::Xaml;
 using namespace Windows::Storage;
 
-private ref class RotationListener sealed {
-internal:
-	RotationListener(IRotativeDirectory* master) : master(master) {}
-
-public:
-	void on_rotation(Platform::Object^ whocares, Platform::Object^ useless) {
-		master->do_rotating_with_this_bad_named_function_which_not_designed_for_client_applications();
-	}
-
-private:
-	IRotativeDirectory* master;
-};
-
 /*************************************************************************************************/
 IRotativeDirectory::IRotativeDirectory(Platform::String^ dirname
 	, Platform::String^ prefix, Platform::String^ suffix, RotationPeriod period, unsigned int count)
 	: period(period), period_count(fxmax(count, 1U)), file_prefix(prefix), file_suffix(suffix) {
 	StorageFolder^ appdata = ApplicationData::Current->LocalFolder;
 	Platform::String^ folder = ((dirname == nullptr) ? appdata->Path : appdata->Path + "\\" + dirname);
-	RotationListener^ listener = ref new RotationListener(this);
 	cancellation_token watcher = this->destructing_watcher.get_token();
+	std::shared_ptr<DisposeGate> gate;
+
+	this->rotator = new TimingWheelRelay([this](long long now_ms) {
+		this->do_rotating_with_this_bad_named_function_which_not_designed_for_client_applications();
+	});
 
-	this->timer = ref new DispatcherTimer();
-	this->timer->Tick += ref new EventHandler<Platform::Object^>(listener, &RotationListener::on_rotation);
-	this->listener = listener;
+	gate = this->rotator->get_gate();
 
 	create_task(StorageFolder::GetFolderFromPathAsync(folder), watcher).then([=](task<StorageFolder^> getting) {
-		try {
-			this->root = getting.get();
-			this->on_folder_ready(this->root, false);
-			this->mission_start();
-		} catch (Platform::Exception^ e) {
-			switch (e->HResult) {
-			case HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND): {
-				create_task(appdata->CreateFolderAsync(dirname), watcher).then([=](task<StorageFolder^> creating) {
-					try {
-						this->root = creating.get();
-						this->on_folder_ready(this->root, true);
-						this->mission_start();
-					} catch (Platform::Exception^ e) {
-						this->on_exception(e);
-					} catch (task_canceled&) {}
-				});
-			}; break;
-			default: {
-				this->on_exception(e);
-			}
-			}
-		} catch (task_canceled&) {}
+		gate->run([=]() {
+			try {
+				this->root = getting.get();
+				this->on_folder_ready(this->root, false);
+				this->mission_start();
+			} catch (Platform::Exception^ e) {
+				switch (e->HResult) {
+				case HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND): {
+					create_task(appdata->CreateFolderAsync(dirname), watcher).then([=](task<StorageFolder^> creating) {
+						gate->run([=]() {
+							try {
+								this->root = creating.get();
+								this->on_folder_ready(this->root, true);
+								this->mission_start();
+							} catch (Platform::Exception^ e) {
+								this->on_exception(e);
+							} catch (task_canceled&) {}
+						});
+					});
+				}; break;
+				default: {
+					this->on_exception(e);
+				}
+				}
+			} catch (task_canceled&) {}
+		});
 	});
 }
 
 IRotativeDirectory::~IRotativeDirectory() {
-	this->timer->Stop();
+	// in case subclasses have not done it, no callbacks run after this
+	this->dispose();
+
+	delete this->rotator;
+}
+
+void IRotativeDirectory::dispose() {
 	this->destructing_watcher.cancel();
+	this->rotator->dispose();
 }
 
 bool IRotativeDirectory::root_ready() {
@@ -105,16 +104,19 @@ void IRotativeDirectory::mission_start() {
 		long long now = current_seconds();
 		Platform::String^ current_file = this->resolve_filename(now);
 
-		create_task(this->root->CreateFileAsync(current_file, cco), watcher).then([=](task<StorageFile^> creating) {
-			try {
-				this->current_file = creating.get();
-				this->on_file_reused(this->current_file, this->resolve_timepoint(now));
+		std::shared_ptr<DisposeGate> gate = this->rotator->get_gate();
 
-				this->timer->Interval = this->resolve_interval();
-				this->timer->Start();
-			} catch (Platform::Exception^ e) {
-				this->on_exception(e);
-			} catch (task_canceled&) {}
+		create_task(this->root->CreateFileAsync(current_file, cco), watcher).then([=](task<StorageFile^> creating) {
+			gate->run([=]() {
+				try {
+					this->current_file = creating.get();
+					this->on_file_reused(this->current_file, this->resolve_timepoint(now));
+
+					this->rotator->arm(this->resolve_interval());
+				} catch (Platform::Exception^ e) {
+					this->on_exception(e);
+				} catch (task_canceled&) {}
+			});
 		});
 	}
 }
@@ -128,23 +130,26 @@ void IRotativeDirectory::do_rotating_with_this_bad_named_function_which_not_desi
 	if (this->current_file->Name->Equals(current_file)) {
 		long long ms = next_timepoint * 1000LL - current_milliseconds();
 		
-		sleep(ms);
-		this->do_rotating_with_this_bad_named_function_which_not_designed_for_client_applications();
+		this->rotator->arm(ms);
 	} else {
 		CreationCollisionOption cco = CreationCollisionOption::ReplaceExisting;
 		cancellation_token watcher = this->destructing_watcher.get_token();
+		std::shared_ptr<DisposeGate> gate = this->rotator->get_gate();
 
-		create_task(this->root->CreateFileAsync(current_file, cco), watcher).then([=](task<StorageFile^> creating) {
-			try {
-				StorageFile^ prev_file = this->current_file;
-
-				this->current_file = creating.get();
-				this->on_file_rotated(prev_file, this->current_file, this->resolve_timepoint(now));
+		// deadlines are wall-clock aligned, re-arm before creating the file in case that fails
+		this->rotator->arm(this->resolve_interval());
 
-				this->timer->Interval = this->resolve_interval();
-			} catch (Platform::Exception^ e) {
-				this->on_exception(e);
-			} catch (task_canceled&) {}
+		create_task(this->root->CreateFileAsync(current_file, cco), watcher).then([=](task<StorageFile^> creating) {
+			gate->run([=]() {
+				try {
+					StorageFile^ prev_file = this->current_file;
+
+					this->current_file = creating.get();
+					this->on_file_rotated(prev_file, this->current_file, this->resolve_timepoint(now));
+				} catch (Platform::Exception^ e) {
+					this->on_exception(e);
+				} catch (task_canceled&) {}
+			});
 		});
 	}
 }
@@ -169,12 +174,8 @@ Platform::String^ IRotativeDirectory::resolve_pathname(long long time_s) {
 	return ((this->root_ready()) ? (this->root->Path + "\\" + filename) : filename);
 }
 
-TimeSpan IRotativeDirectory::resolve_interval() {
-	TimeSpan timepoint = make_timespan_from_seconds(current_ceiling_seconds(this->span));
-
-	timepoint.Duration -= current_100nanoseconds();
-
-	return timepoint;
+long long IRotativeDirectory::resolve_interval() {
+	return current_ceiling_seconds(this->span) * 1000LL - current_milliseconds();
 }
 
 void IRotativeDirectory::on_file_reused(StorageFile^ file, long long timepoint) {
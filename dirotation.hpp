@@ -4,6 +4,8 @@
 
 #include "datum/time.hpp"
 
+#include "timewheel.hpp"
+
 namespace WarGrey::SCADA {
 	private enum class RotationPeriod { Daily, Hourly, Minutely, Secondly };
 
@@ -36,9 +38,20 @@ namespace WarGrey::SCADA {
 	protected:
 		virtual void on_exception(Platform::Exception^ e);
 
+	protected:
+		/** NOTE
+		 * Rotations are relayed to the thread that creates the directory if it is the UI thread,
+		 *   and directories created off the UI thread get them on the thread of the shared wheel,
+		 *   whereas they used to be fired by a `DispatcherTimer` on the UI thread.
+		 *
+		 * `dispose()` cancels the rotation and waits for the running callback, the destructor does it anyway,
+		 *   but by then the subclasses are gone, so subclasses should still `dispose()` first in their destructors.
+		 */
+		void dispose();
+
 	private:
 		void mission_start();
-		Windows::Foundation::TimeSpan resolve_interval();
+		long long resolve_interval();
 		
 	private:
 		Concurrency::cancellation_token_source destructing_watcher;
@@ -52,8 +65,7 @@ namespace WarGrey::SCADA {
 		unsigned int period_count;
 
 	private:
-		Windows::UI::Xaml::DispatcherTimer^ timer;
-		Platform::Object^ listener;
+		WarGrey::SCADA::TimingWheelRelay* rotator;
 		long long span;
 	};
 }
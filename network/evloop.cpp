@@ -0,0 +1,741 @@
+#include <ppltasks.h>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <string>
+#include <chrono>
+#include <climits>
+
+#include "network/evloop.hpp"
+
+#include "datum/time.hpp"
+
+#pragma comment(lib, "ws2_32.lib")
+
+using namespace WarGrey::SCADA;
+
+using namespace Concurrency;
+
+static const unsigned long long invalid_socket = (unsigned long long)(INVALID_SOCKET);
+static const long long max_poll_timeout = 1000LL;
+
+static void winsock_startup() {
+	static std::once_flag started;
+
+	std::call_once(started, []() {
+		WSADATA data;
+
+		WSAStartup(MAKEWORD(2, 2), &data);
+	});
+}
+
+static int resolve_address(const std::wstring& host, const std::wstring& service, std::vector<std::vector<unsigned char>>& addresses) {
+	ADDRINFOW hints = {};
+	ADDRINFOW* result = nullptr;
+	int error = 0;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	error = GetAddrInfoW(host.c_str(), service.c_str(), &hints, &result);
+
+	if (error == 0) {
+		for (ADDRINFOW* info = result; info != nullptr; info = info->ai_next) {
+			const unsigned char* addr = reinterpret_cast<const unsigned char*>(info->ai_addr);
+
+			if (addr != nullptr) {
+				addresses.emplace_back(addr, addr + info->ai_addrlen);
+			}
+		}
+
+		if (result != nullptr) {
+			FreeAddrInfoW(result);
+		}
+
+		if (addresses.empty()) {
+			error = WSAHOST_NOT_FOUND;
+		}
+	}
+
+	return error;
+}
+
+static bool socket_set_nonblocking(SOCKET s) {
+	u_long nonblocking = 1;
+
+	return (ioctlsocket(s, FIONBIO, &nonblocking) == 0);
+}
+
+static SOCKET make_waker() {
+	/** NOTE
+	 * WSAPoll cannot wait for events, a datagram socket connected to itself on the loopback wakes the loop up instead,
+	 *   which is allowed for UWP apps as long as it stays within the process.
+	 */
+	SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (s != INVALID_SOCKET) {
+		sockaddr_in address = {};
+		int size = int(sizeof(address));
+
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = 0;
+
+		if ((bind(s, reinterpret_cast<sockaddr*>(&address), size) != 0)
+			|| (getsockname(s, reinterpret_cast<sockaddr*>(&address), &size) != 0)
+			|| (connect(s, reinterpret_cast<sockaddr*>(&address), size) != 0)
+			|| (!socket_set_nonblocking(s))) {
+			closesocket(s);
+			s = INVALID_SOCKET;
+		}
+	}
+
+	return s;
+}
+
+/*************************************************************************************************/
+TCPEventChannel::TCPEventChannel(TCPEventLoop* loop, ITCPEventChannelPort* port, size_t buffer_size)
+	: loop(loop), port(port), state(TCPChannelState::Closed), connect_timeout(5000LL), socket(invalid_socket) {
+	this->inbox.resize((buffer_size > 0U) ? buffer_size : 4096U);
+	this->resolver = std::make_shared<DisposeGate>();
+}
+
+void TCPEventChannel::connect(Platform::String^ host, unsigned short port, long long delay_ms) {
+	{ std::unique_lock<std::mutex> guard(this->section);
+		this->host.assign(host->Data(), host->Length());
+		this->service = std::to_wstring(port);
+		this->addresses.clear();
+		this->address_idx = 0U;
+	}
+
+	this->reconnect(delay_ms);
+}
+
+void TCPEventChannel::reconnect(long long delay_ms) {
+	this->loop->post([this, delay_ms]() {
+		if ((!this->closing) && (this->state.load() == TCPChannelState::Closed)) {
+			if (delay_ms > 0LL) {
+				this->loop->wheel->arm(this, delay_ms);
+			} else {
+				this->do_connect();
+			}
+		}
+	});
+}
+
+void TCPEventChannel::close() {
+	this->loop->post([this]() {
+		if ((!this->closing) && (this->state.load() != TCPChannelState::Closed)) {
+			this->do_close(0, true);
+		}
+	});
+}
+
+bool TCPEventChannel::send(const uint8* data, size_t size) {
+	bool okay = false;
+
+	{ std::unique_lock<std::mutex> guard(this->section);
+		okay = (this->state.load() == TCPChannelState::Connected);
+
+		if (okay && (size > 0U)) {
+			if (this->outbox.empty()) {
+				this->outbox_since = current_monotonic_inexact_milliseconds();
+			}
+
+			this->outbox.insert(this->outbox.end(), data, data + size);
+		}
+	}
+
+	if (okay && (!this->loop->in_loop_thread())) {
+		this->loop->wakeup();
+	}
+
+	return okay;
+}
+
+bool TCPEventChannel::connected() {
+	return (this->state.load() == TCPChannelState::Connected);
+}
+
+size_t TCPEventChannel::pending_bytes() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	return this->outbox.size() - this->outbox_offset;
+}
+
+void TCPEventChannel::set_connect_timeout(long long timeout_ms) {
+	this->connect_timeout.store(timeout_ms);
+}
+
+void TCPEventChannel::on_timeout(long long now_ms) {
+	if (!this->closing) {
+		switch (this->state.load()) {
+		case TCPChannelState::Connecting: this->do_connect_failed(WSAETIMEDOUT); break;
+		case TCPChannelState::Closed: this->do_connect(); break;
+		default: /* connected in the meantime */; break;
+		}
+	}
+}
+
+/*************************************************************************************************/
+void TCPEventChannel::do_connect() {
+	std::vector<unsigned char> address;
+	SOCKET s = INVALID_SOCKET;
+	int error = 0;
+
+	{ std::unique_lock<std::mutex> guard(this->section);
+		if (this->address_idx < this->addresses.size()) {
+			address = this->addresses[this->address_idx];
+		}
+	}
+
+	if (!address.empty()) {
+		const sockaddr* remote = reinterpret_cast<const sockaddr*>(address.data());
+
+		s = ::socket(remote->sa_family, SOCK_STREAM, IPPROTO_TCP);
+
+		if (s == INVALID_SOCKET) {
+			error = WSAGetLastError();
+		} else {
+			BOOL nodelay = TRUE;
+
+			setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nodelay), int(sizeof(nodelay)));
+
+			this->socket = (unsigned long long)(s);
+			this->state.store(TCPChannelState::Connecting);
+
+			if (!socket_set_nonblocking(s)) {
+				error = WSAGetLastError();
+			} else if (::connect(s, remote, int(address.size())) == 0) {
+				this->do_establish();
+			} else {
+				error = WSAGetLastError();
+
+				if (error == WSAEWOULDBLOCK) {
+					long long timeout = this->connect_timeout.load();
+
+					// WSAPoll might never report the failure of a non-blocking connecting
+					if (timeout > 0LL) {
+						this->loop->wheel->arm(this, timeout);
+					}
+
+					error = 0;
+				}
+			}
+		}
+
+		if (error != 0) {
+			this->do_connect_failed(error);
+		}
+	} else if (!this->resolving) {
+		this->do_resolve();
+	}
+}
+
+void TCPEventChannel::do_resolve() {
+	std::shared_ptr<DisposeGate> gate = this->resolver;
+	TCPEventLoop* loop = this->loop;
+	std::wstring host, service;
+
+	{ std::unique_lock<std::mutex> guard(this->section);
+		host = this->host;
+		service = this->service;
+	}
+
+	this->resolving = true;
+
+	create_task([=]() {
+		std::vector<std::vector<unsigned char>> addresses;
+		int error = resolve_address(host, service, addresses);
+
+		// the channel might be closed in the meantime, and the loop might be gone then
+		gate->run([=]() {
+			loop->post([=]() {
+				gate->run([=]() { this->on_resolved(host, addresses, error); });
+			});
+		});
+	});
+}
+
+void TCPEventChannel::on_resolved(const std::wstring& host, const std::vector<std::vector<unsigned char>>& addresses, int error) {
+	bool outdated = false;
+
+	this->resolving = false;
+
+	if (!this->closing) {
+		{ std::unique_lock<std::mutex> guard(this->section);
+			outdated = (host.compare(this->host) != 0);
+
+			if ((!outdated) && (error == 0)) {
+				this->addresses = addresses;
+				this->address_idx = 0U;
+			}
+		}
+
+		if (this->state.load() == TCPChannelState::Closed) {
+			if (outdated || (error == 0)) { // `connect()` to another host in the meantime
+				this->do_connect();
+			} else {
+				this->do_close(error, true);
+			}
+		}
+	}
+}
+
+void TCPEventChannel::do_establish() {
+	this->loop->wheel->cancel(this);
+	this->state.store(TCPChannelState::Connected);
+
+	if (this->port != nullptr) {
+		this->port->on_channel_connected(this);
+	}
+}
+
+void TCPEventChannel::do_close(int error, bool notify) {
+	this->loop->wheel->cancel(this);
+
+	if (this->socket != invalid_socket) {
+		closesocket(SOCKET(this->socket));
+		this->socket = invalid_socket;
+	}
+
+	{ std::unique_lock<std::mutex> guard(this->section);
+		this->state.store(TCPChannelState::Closed);
+		this->outbox.clear();
+		this->outbox_offset = 0U;
+	}
+
+	if (notify && (this->port != nullptr)) {
+		this->port->on_channel_closed(this, error);
+	}
+}
+
+void TCPEventChannel::do_connect_failed(int error) {
+	bool exhausted = true;
+
+	{ std::unique_lock<std::mutex> guard(this->section);
+		if (this->address_idx + 1U < this->addresses.size()) {
+			this->address_idx++;
+			exhausted = false;
+		} else {
+			this->address_idx = 0U;
+		}
+	}
+
+	if (exhausted) {
+		this->do_close(error, true);
+	} else {
+		// the port only hears about the connecting once all addresses have failed
+		this->do_close(error, false);
+		this->do_connect();
+	}
+}
+
+void TCPEventChannel::do_receive() {
+	while ((!this->closing) && (this->state.load() == TCPChannelState::Connected)) {
+		double start = current_monotonic_inexact_milliseconds();
+		int size = recv(SOCKET(this->socket), reinterpret_cast<char*>(this->inbox.data()), int(this->inbox.size()), 0);
+
+		if (size > 0) {
+			this->loop->received.fetch_add((unsigned long long)(size), std::memory_order_relaxed);
+
+			if (this->port != nullptr) {
+				this->port->on_channel_received(this, this->inbox.data(), size_t(size), current_monotonic_inexact_milliseconds() - start);
+			}
+
+			if (size_t(size) < this->inbox.size()) {
+				break;
+			}
+		} else {
+			int error = ((size == 0) ? 0 : WSAGetLastError());
+
+			if (error != WSAEWOULDBLOCK) {
+				// `size == 0` means the device has closed the connection
+				this->do_close(error, true);
+			}
+
+			break;
+		}
+	}
+}
+
+void TCPEventChannel::do_send() {
+	std::unique_lock<std::mutex> guard(this->section);
+	size_t total = this->outbox.size();
+	int error = 0;
+
+	while (this->outbox_offset < total) {
+		size_t rest = total - this->outbox_offset;
+		int chunk = ((rest > size_t(INT_MAX)) ? INT_MAX : int(rest));
+		int size = ::send(SOCKET(this->socket), reinterpret_cast<const char*>(this->outbox.data() + this->outbox_offset), chunk, 0);
+
+		if (size > 0) {
+			this->outbox_offset += size_t(size);
+		} else {
+			error = WSAGetLastError();
+			break;
+		}
+	}
+
+	if ((total > 0U) && (this->outbox_offset >= total)) {
+		double span_ms = current_monotonic_inexact_milliseconds() - this->outbox_since;
+
+		this->outbox.clear();
+		this->outbox_offset = 0U;
+		guard.unlock();
+
+		this->loop->sent.fetch_add((unsigned long long)(total), std::memory_order_relaxed);
+
+		if (this->port != nullptr) {
+			this->port->on_channel_sent(this, total, span_ms);
+		}
+	} else if ((error != 0) && (error != WSAEWOULDBLOCK)) {
+		guard.unlock();
+		this->do_close(error, true);
+	}
+}
+
+short TCPEventChannel::interests() {
+	short events = 0;
+
+	switch (this->state.load()) {
+	case TCPChannelState::Connecting: events = POLLWRNORM; break;
+	case TCPChannelState::Connected: {
+		std::unique_lock<std::mutex> guard(this->section);
+
+		events = ((this->outbox_offset < this->outbox.size()) ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM);
+	}; break;
+	default: /* not polled */; break;
+	}
+
+	return events;
+}
+
+/*************************************************************************************************/
+TCPEventLoop::TCPEventLoop(long long tick_ms)
+	: notified(false), stopping(false), channel_count(0U), iterations(0ULL), wakeups(0ULL), received(0ULL), sent(0ULL) {
+	winsock_startup();
+
+	this->mailbox_stub.next.store(nullptr);
+	this->mailbox_head.store(&this->mailbox_stub);
+	this->mailbox_tail = &this->mailbox_stub;
+
+	this->wheel = new TimingWheel(tick_ms, false);
+	this->waker = (unsigned long long)(make_waker());
+	this->worker = std::thread([this]() { this->run(); });
+}
+
+TCPEventLoop::~TCPEventLoop() {
+	if (this->worker.joinable()) {
+		this->stopping.store(true);
+		this->wakeup();
+		this->worker.join();
+
+		this->section.lock();
+		this->stopped = true;
+		this->section.unlock();
+		this->executed.notify_all();
+	}
+
+	while (!this->channels.empty()) {
+		TCPEventChannel* channel = this->channels.back();
+
+		this->detach(channel);
+		delete channel;
+	}
+
+	if (this->waker != invalid_socket) {
+		closesocket(SOCKET(this->waker));
+	}
+
+	// jobs posted after the loop has gone, nothing to run them for
+	for (Job* job = this->pop_job(); job != nullptr; job = this->pop_job()) {
+		delete job;
+	}
+
+	delete this->wheel;
+}
+
+TCPEventChannel* TCPEventLoop::open_channel(ITCPEventChannelPort* port, size_t buffer_size) {
+	TCPEventChannel* channel = new TCPEventChannel(this, port, buffer_size);
+
+	this->post([=]() {
+		// the channel might be closed before it gets here
+		if (!channel->closing) {
+			this->channels.push_back(channel);
+			this->channel_count.store(this->channels.size());
+		}
+	});
+
+	return channel;
+}
+
+void TCPEventLoop::close_channel(TCPEventChannel* channel) {
+	if (channel != nullptr) {
+		if (this->in_loop_thread()) {
+			// jobs already posted for the channel should see it closing
+			this->detach(channel);
+			this->post([=]() { delete channel; });
+		} else {
+			this->execute([=]() {
+				this->detach(channel);
+				delete channel;
+			});
+		}
+	}
+}
+
+void TCPEventLoop::post(std::function<void()> job) {
+	Job* node = new Job();
+
+	node->run = std::move(job);
+	this->push_job(node);
+	this->wakeup();
+}
+
+void TCPEventLoop::execute(std::function<void()> job) {
+	if (this->in_loop_thread()) {
+		job();
+	} else {
+		Job* node = new Job();
+		bool done = false;
+
+		node->run = [=, &done]() {
+			job();
+
+			this->section.lock();
+			done = true;
+			this->section.unlock();
+			this->executed.notify_all();
+		};
+
+		this->push_job(node);
+		this->wakeup();
+
+		{ std::unique_lock<std::mutex> guard(this->section);
+			this->executed.wait(guard, [&]() { return done || this->stopped; });
+		}
+	}
+}
+
+bool TCPEventLoop::pin(unsigned int logical_processor) {
+	/** NOTE
+	 * UWP apps cannot set affinity masks, but they can select CPU sets,
+	 *   which Windows treats as a soft affinity rather than a hard one.
+	 */
+	std::vector<unsigned char> buffer;
+	ULONG size = 0;
+	bool okay = false;
+
+	GetSystemCpuSetInformation(nullptr, 0, &size, GetCurrentProcess(), 0);
+
+	if (size > 0) {
+		buffer.resize(size);
+
+		if (GetSystemCpuSetInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data()), size, &size, GetCurrentProcess(), 0)) {
+			for (ULONG offset = 0; offset < size;) {
+				auto info = reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data() + offset);
+
+				if ((info->Type == CpuSetInformation) && (info->CpuSet.LogicalProcessorIndex == logical_processor)) {
+					ULONG id = info->CpuSet.Id;
+
+					okay = (SetThreadSelectedCpuSets(HANDLE(this->worker.native_handle()), &id, 1) != FALSE);
+					break;
+				}
+
+				offset += info->Size;
+			}
+		}
+	}
+
+	return okay;
+}
+
+bool TCPEventLoop::in_loop_thread() {
+	return (std::this_thread::get_id() == this->worker.get_id());
+}
+
+TimingWheel* TCPEventLoop::get_wheel() {
+	return this->wheel;
+}
+
+void TCPEventLoop::statistics(TCPEventLoopStatistics* stat) {
+	stat->channels = this->channel_count.load();
+	stat->iterations = this->iterations.load();
+	stat->wakeups = this->wakeups.load();
+	stat->received = this->received.load();
+	stat->sent = this->sent.load();
+}
+
+/*************************************************************************************************/
+void TCPEventLoop::run() {
+	std::vector<WSAPOLLFD> fds;
+	std::vector<TCPEventChannel*> polling;
+
+	while (this->run_jobs()) {
+		long long now = current_monotonic_milliseconds();
+		long long timeout = this->wheel->next_timeout_ms(now);
+		int ready = 0;
+
+		fds.clear();
+		polling.clear();
+
+		if (this->waker != invalid_socket) {
+			fds.push_back({ SOCKET(this->waker), POLLRDNORM, 0 });
+		} else if ((timeout < 0LL) || (timeout > this->wheel->tick_ms())) {
+			// no way to wake up, poll the mailbox every tick
+			timeout = this->wheel->tick_ms();
+		}
+
+		for (auto channel : this->channels) {
+			short events = channel->interests();
+
+			if (events != 0) {
+				fds.push_back({ SOCKET(channel->socket), events, 0 });
+				polling.push_back(channel);
+			}
+		}
+
+		if ((timeout < 0LL) || (timeout > max_poll_timeout)) {
+			timeout = max_poll_timeout;
+		}
+
+		if (fds.empty()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+		} else {
+			ready = WSAPoll(fds.data(), ULONG(fds.size()), INT(timeout));
+		}
+
+		this->iterations.fetch_add(1ULL, std::memory_order_relaxed);
+
+		if (ready > 0) {
+			size_t base = fds.size() - polling.size();
+
+			if ((base > 0U) && (fds[0].revents != 0)) {
+				this->drain_wakeups();
+			}
+
+			for (size_t idx = 0; idx < polling.size(); idx++) {
+				TCPEventChannel* channel = polling[idx];
+				short revents = fds[base + idx].revents;
+
+				if ((revents != 0) && (!channel->closing)) {
+					if (channel->state.load() == TCPChannelState::Connecting) {
+						int error = 0;
+						int size = int(sizeof(error));
+
+						if (getsockopt(SOCKET(channel->socket), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &size) != 0) {
+							error = WSAGetLastError();
+						}
+
+						if ((error == 0) && ((revents & (POLLERR | POLLHUP)) == 0)) {
+							channel->do_establish();
+						} else {
+							channel->do_connect_failed((error == 0) ? WSAECONNREFUSED : error);
+						}
+					} else if (channel->state.load() == TCPChannelState::Connected) {
+						if ((revents & (POLLRDNORM | POLLERR | POLLHUP)) != 0) {
+							channel->do_receive();
+						}
+
+						if ((revents & POLLWRNORM) != 0) {
+							if ((!channel->closing) && (channel->state.load() == TCPChannelState::Connected)) {
+								channel->do_send();
+							}
+						}
+					}
+				}
+			}
+		}
+
+		this->wheel->advance(current_monotonic_milliseconds());
+	}
+}
+
+void TCPEventLoop::wakeup() {
+	if ((this->waker != invalid_socket) && (!this->notified.exchange(true))) {
+		char signal = 0;
+
+		::send(SOCKET(this->waker), &signal, 1, 0);
+	}
+}
+
+void TCPEventLoop::drain_wakeups() {
+	char signals[64];
+
+	// jobs posted since now will wake the loop up again
+	this->notified.store(false);
+	this->wakeups.fetch_add(1ULL, std::memory_order_relaxed);
+
+	while (recv(SOCKET(this->waker), signals, int(sizeof(signals)), 0) > 0);
+}
+
+bool TCPEventLoop::run_jobs() {
+	bool running = !this->stopping.load();
+
+	// also for the last round, jobs might carry channels to register or callers waiting for them
+	for (Job* job = this->pop_job(); job != nullptr; job = this->pop_job()) {
+		job->run();
+		delete job;
+	}
+
+	return running;
+}
+
+void TCPEventLoop::detach(TCPEventChannel* channel) {
+	channel->resolver->close();
+	channel->closing = true;
+	channel->do_close(0, false);
+	channel->port = nullptr;
+
+	for (auto it = this->channels.begin(); it != this->channels.end(); it++) {
+		if ((*it) == channel) {
+			this->channels.erase(it);
+			break;
+		}
+	}
+
+	this->channel_count.store(this->channels.size());
+}
+
+/*************************************************************************************************/
+void TCPEventLoop::push_job(Job* job) {
+	job->next.store(nullptr, std::memory_order_relaxed);
+	this->mailbox_head.exchange(job, std::memory_order_acq_rel)->next.store(job, std::memory_order_release);
+}
+
+TCPEventLoop::Job* TCPEventLoop::pop_job() {
+	/** NOTE
+	 * Dmitry Vyukov's intrusive MPSC queue, the stub keeps the queue non-empty,
+	 *   `nullptr` might also mean that a producer is in the middle of pushing, it will wake the loop up once done.
+	 */
+	Job* tail = this->mailbox_tail;
+	Job* next = tail->next.load(std::memory_order_acquire);
+
+	if (tail == &this->mailbox_stub) {
+		if (next == nullptr) {
+			return nullptr;
+		}
+
+		this->mailbox_tail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next == nullptr) {
+		if (tail != this->mailbox_head.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+
+		this->push_job(&this->mailbox_stub);
+		next = tail->next.load(std::memory_order_acquire);
+
+		if (next == nullptr) {
+			return nullptr;
+		}
+	}
+
+	this->mailbox_tail = next;
+
+	return tail;
+}
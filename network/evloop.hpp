@@ -0,0 +1,279 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#include "network/tcp.hpp"
+
+#include "timewheel.hpp"
+
+namespace WarGrey::SCADA {
+	class TCPEventLoop;
+	class TCPEventChannel;
+
+	private enum class TCPChannelState { Closed, Connecting, Connected };
+
+	private struct TCPEventLoopStatistics {
+		size_t channels;
+		unsigned long long iterations;
+		unsigned long long wakeups;
+		unsigned long long received; // bytes
+		unsigned long long sent;     // bytes
+	};
+
+	/** NOTE
+	 * All callbacks are invoked on the thread of the loop, do not block it.
+	 */
+	private class ITCPEventChannelPort abstract {
+	public:
+		virtual void on_channel_connected(WarGrey::SCADA::TCPEventChannel* channel) = 0;
+		virtual void on_channel_closed(WarGrey::SCADA::TCPEventChannel* channel, int error) = 0;
+		virtual void on_channel_received(WarGrey::SCADA::TCPEventChannel* channel, const uint8* data, size_t size, double span_ms) = 0;
+		virtual void on_channel_sent(WarGrey::SCADA::TCPEventChannel* channel, size_t bytes, double span_ms) = 0;
+	};
+
+	/** NOTE
+	 * A non-blocking socket driven by a `TCPEventLoop`, all methods are thread-safe,
+	 *   the actual work is done on the thread of the loop.
+	 *
+	 * The hostname is resolved on the thread pool, neither the caller nor the loop waits for it,
+	 *   a failed resolving closes the channel with `WSAHOST_NOT_FOUND` or so,
+	 *   and `reconnect()` reuses the resolved addresses (or resolves them again if there is none).
+	 *
+	 * The resolved addresses are tried in order, the channel is closed only after all of them have failed,
+	 *   and the next round starts over with the first one.
+	 */
+	private class TCPEventChannel : public WarGrey::SCADA::ITimingWheelTask {
+		friend class WarGrey::SCADA::TCPEventLoop;
+
+	public:
+		void connect(Platform::String^ host, unsigned short port, long long delay_ms = 0LL);
+		void reconnect(long long delay_ms);
+		void close();
+
+	public:
+		bool send(const uint8* data, size_t size); // `false` if not connected
+		bool connected();
+		size_t pending_bytes();
+
+	public:
+		WarGrey::SCADA::TCPEventLoop* get_loop() { return this->loop; }
+		WarGrey::SCADA::TCPChannelState get_state() { return this->state.load(); }
+		void set_connect_timeout(long long timeout_ms);
+
+	protected:
+		void on_timeout(long long now_ms) override; // connecting timed out or reconnecting
+
+	private:
+		TCPEventChannel(WarGrey::SCADA::TCPEventLoop* loop, WarGrey::SCADA::ITCPEventChannelPort* port, size_t buffer_size);
+		~TCPEventChannel() noexcept {}
+
+	private: // on the thread of the loop
+		void do_connect();
+		void do_resolve();
+		void do_establish();
+		void do_close(int error, bool notify);
+		void do_connect_failed(int error);
+		void do_receive();
+		void do_send();
+		short interests();
+
+	private:
+		void on_resolved(const std::wstring& host, const std::vector<std::vector<unsigned char>>& addresses, int error);
+
+	private:
+		WarGrey::SCADA::TCPEventLoop* loop;
+		WarGrey::SCADA::ITCPEventChannelPort* port;
+		std::atomic<WarGrey::SCADA::TCPChannelState> state;
+		std::atomic<long long> connect_timeout;
+		unsigned long long socket;
+		std::vector<uint8> inbox;
+		std::shared_ptr<WarGrey::SCADA::DisposeGate> resolver;
+		bool resolving = false;
+		bool closing = false;
+
+	private:
+		std::mutex section;
+		std::wstring host;
+		std::wstring service;
+		std::vector<std::vector<unsigned char>> addresses;
+		size_t address_idx = 0U;
+		std::vector<uint8> outbox;
+		size_t outbox_offset = 0U;
+		double outbox_since = 0.0;
+	};
+
+	/** NOTE
+	 * An event loop of non-blocking sockets on its own thread (via `WSAPoll`),
+	 *   so that thousands of device connections cost a few threads rather than several async objects each.
+	 *
+	 * The loop drives its own non-threaded timing wheel, tasks armed on `get_wheel()` are fired on the thread of the loop,
+	 *   and jobs posted from other threads are run in order on the thread of the loop.
+	 *
+	 * The mailbox of jobs is a lock-free MPSC queue, posting never contends with the loop or other producers.
+	 * Jobs posted before the loop is destroyed are still run, so that no channels or waiters are left behind.
+	 */
+	private class TCPEventLoop {
+		friend class WarGrey::SCADA::TCPEventChannel;
+
+	public:
+		virtual ~TCPEventLoop() noexcept;
+		TCPEventLoop(long long tick_ms = 10LL);
+
+	public:
+		WarGrey::SCADA::TCPEventChannel* open_channel(WarGrey::SCADA::ITCPEventChannelPort* port, size_t buffer_size = 4096U);
+
+		/** NOTE
+		 * The channel is destroyed once the loop lets it go, no callbacks will be invoked on its port since then.
+		 * Waits for the loop unless called on the thread of the loop.
+		 */
+		void close_channel(WarGrey::SCADA::TCPEventChannel* channel);
+
+	public:
+		void post(std::function<void()> job);
+		void execute(std::function<void()> job); // waits for the job unless called on the thread of the loop
+		bool pin(unsigned int logical_processor); // best-effort
+		bool in_loop_thread();
+		WarGrey::SCADA::TimingWheel* get_wheel();
+		void statistics(WarGrey::SCADA::TCPEventLoopStatistics* stat);
+
+	private:
+		void run();
+		void wakeup();
+		void drain_wakeups();
+		bool run_jobs();
+		void detach(WarGrey::SCADA::TCPEventChannel* channel);
+
+	private:
+		struct Job {
+			std::function<void()> run;
+			std::atomic<WarGrey::SCADA::TCPEventLoop::Job*> next;
+		};
+
+		void push_job(WarGrey::SCADA::TCPEventLoop::Job* job);
+		WarGrey::SCADA::TCPEventLoop::Job* pop_job(); // on the thread of the loop
+
+	private:
+		std::atomic<WarGrey::SCADA::TCPEventLoop::Job*> mailbox_head;
+		WarGrey::SCADA::TCPEventLoop::Job* mailbox_tail;
+		WarGrey::SCADA::TCPEventLoop::Job mailbox_stub;
+
+	private:
+		std::mutex section;
+		std::condition_variable executed;
+		std::vector<WarGrey::SCADA::TCPEventChannel*> channels;
+		std::atomic<bool> notified;
+		std::atomic<bool> stopping;
+		std::thread worker;
+		bool stopped = false;
+
+	private:
+		WarGrey::SCADA::TimingWheel* wheel;
+		unsigned long long waker;
+		std::atomic<size_t> channel_count;
+		std::atomic<unsigned long long> iterations;
+		std::atomic<unsigned long long> wakeups;
+		std::atomic<unsigned long long> received;
+		std::atomic<unsigned long long> sent;
+	};
+
+	/*********************************************************************************************/
+	/** NOTE
+	 * `ITCPFeedBackConnection` on a `TCPEventChannel`, the connection reconnects after `retry_ms` once it is lost,
+	 *   `suicide()` closes the socket to trigger a reconnection.
+	 *
+	 * Subclasses handle the payload in `on_data_received()` on the thread of the loop,
+	 *   and their timers should be armed on `this->get_loop()->get_wheel()` to stay on that thread.
+	 *
+	 * Subclasses should `dispose()` in their destructors, so that the loop never calls into a half-destroyed object.
+	 */
+	template<class TCPStateListener>
+	private class ITCPEventConnection abstract
+		: public WarGrey::SCADA::ITCPFeedBackConnection<TCPStateListener>
+		, public WarGrey::SCADA::ITCPEventChannelPort {
+	public:
+		virtual ~ITCPEventConnection() noexcept {
+			this->dispose();
+		}
+
+		ITCPEventConnection(WarGrey::SCADA::TCPEventLoop* loop, WarGrey::SCADA::TCPType type,
+			Platform::String^ host, unsigned short port, long long retry_ms = 2000LL)
+			: ITCPFeedBackConnection<TCPStateListener>(type, loop->get_wheel()), loop(loop), host(host), port(port), retry_ms(retry_ms) {
+			this->channel = loop->open_channel(this);
+			this->reset_heartbeat();
+		}
+
+	public:
+		Platform::String^ device_hostname() override {
+			return this->host;
+		}
+
+		void shake_hands() override {
+			this->channel->connect(this->host, this->port);
+		}
+
+		bool connected() override {
+			return this->channel->connected();
+		}
+
+		void suicide() override {
+			this->channel->close();
+		}
+
+	public:
+		WarGrey::SCADA::TCPEventLoop* get_loop() {
+			return this->loop;
+		}
+
+	public:
+		void on_channel_connected(WarGrey::SCADA::TCPEventChannel* channel) override {
+			this->reset_heartbeat();
+			this->notify_connectivity_changed();
+		}
+
+		void on_channel_closed(WarGrey::SCADA::TCPEventChannel* channel, int error) override {
+			this->notify_connectivity_changed();
+			this->channel->reconnect(this->retry_ms);
+		}
+
+		void on_channel_received(WarGrey::SCADA::TCPEventChannel* channel, const uint8* data, size_t size, double span_ms) override {
+			this->on_data_received(data, size);
+			this->notify_data_received((long long)(size), span_ms);
+		}
+
+		void on_channel_sent(WarGrey::SCADA::TCPEventChannel* channel, size_t bytes, double span_ms) override {
+			this->notify_data_sent((long long)(bytes), span_ms);
+		}
+
+	protected:
+		bool send_data(const uint8* data, size_t size) {
+			return this->channel->send(data, size);
+		}
+
+		void dispose() {
+			WarGrey::SCADA::ITCPConnection::dispose();
+
+			if (this->channel != nullptr) {
+				this->loop->close_channel(this->channel);
+				this->channel = nullptr;
+			}
+		}
+
+	protected:
+		virtual void on_data_received(const uint8* data, size_t size) = 0;
+
+	private:
+		WarGrey::SCADA::TCPEventLoop* loop;
+		WarGrey::SCADA::TCPEventChannel* channel;
+		Platform::String^ host;
+		unsigned short port;
+		long long retry_ms;
+	};
+
+	typedef WarGrey::SCADA::ITCPEventConnection<WarGrey::SCADA::ITCPStateListener> ITCPEventStatedConnection;
+}
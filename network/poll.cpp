@@ -0,0 +1,292 @@
+#include "network/poll.hpp"
+
+#include "datum/time.hpp"
+#include "datum/hash.hpp"
+
+using namespace WarGrey::SCADA;
+
+static const double l00ns_ms = 10000.0;
+
+/*************************************************************************************************/
+namespace WarGrey::SCADA {
+	private class TCPPollTask : public ITimingWheelTask {
+	public:
+		TCPPollTask(TCPPollScheduler* master, ITCPConnection* device) : master(master), device(device) {
+			this->statistics.polls = 0LL;
+			this->statistics.overruns = 0LL;
+			this->statistics.last_jitter_ms = 0.0;
+			this->statistics.max_jitter_ms = 0.0;
+			this->statistics.mean_jitter_ms = 0.0;
+		}
+
+	public:
+		void start() {
+			this->master->wheel->arm(this, this->next_deadline_ms(current_monotonic_100nanoseconds()));
+		}
+
+		void on_timeout(long long now_ms) override {
+			long long now = current_monotonic_100nanoseconds();
+			long long epoch = this->master->epoch;
+			long long period = this->master->period;
+			long long cycle = 0LL;
+			double jitter = 0.0;
+			std::unique_lock<std::mutex> guard(this->master->section);
+			long long elapsed = now - epoch - this->phase;
+
+			this->firing_thread = std::this_thread::get_id();
+
+			cycle = ((elapsed >= 0LL) ? (elapsed / period) : -1LL);
+
+			if ((elapsed >= 0LL) && (cycle > this->last_cycle)) { // account the current cycle
+				jitter = double(elapsed - cycle * period) / l00ns_ms;
+
+				if ((this->statistics.polls > 0LL) && (cycle > this->last_cycle + 1LL)) {
+					this->statistics.overruns += cycle - this->last_cycle - 1LL;
+				}
+
+				this->last_cycle = cycle;
+				this->statistics.polls++;
+				this->statistics.last_jitter_ms = jitter;
+				this->statistics.mean_jitter_ms += (jitter - this->statistics.mean_jitter_ms) / double(this->statistics.polls);
+
+				if (jitter > this->statistics.max_jitter_ms) {
+					this->statistics.max_jitter_ms = jitter;
+				}
+
+				guard.unlock();
+				this->device->send_scheduled_request(cycle, period / 10000LL, (now - epoch) / 10000LL);
+			} else { // the phase has just been moved forward
+				guard.unlock();
+			}
+
+			guard.lock();
+			this->firing_thread = std::thread::id();
+
+			if (this->dead) { // removed by the device itself while polling
+				guard.unlock();
+				delete this;
+			} else {
+				guard.unlock();
+				this->master->wheel->arm(this, this->next_deadline_ms(current_monotonic_100nanoseconds()));
+			}
+		}
+
+	public:
+		TCPPollScheduler* master;
+		ITCPConnection* device;
+		TCPPollStatistics statistics;
+		long long phase = 0LL;
+		long long last_cycle = -1LL;
+		std::thread::id firing_thread;
+		bool dead = false;
+
+	private:
+		long long next_deadline_ms(long long now) {
+			std::unique_lock<std::mutex> guard(this->master->section);
+			long long elapsed = now - this->master->epoch - this->phase;
+			long long period = this->master->period;
+			long long next_cycle = ((elapsed >= 0LL) ? (elapsed / period + 1LL) : 0LL);
+
+			if (next_cycle <= this->last_cycle) { // the phase has just been moved backward
+				next_cycle = this->last_cycle + 1LL;
+			}
+
+			return (next_cycle * period - elapsed + 9999LL) / 10000LL;
+		}
+	};
+}
+
+/*************************************************************************************************/
+TCPPollScheduler::TCPPollScheduler(int rate, unsigned int shift, TimingWheel* wheel)
+	: wheel((wheel == nullptr) ? TimingWheel::shared() : wheel) {
+	this->period = make_timespan_from_rate(rate, shift).Duration;
+
+	if (this->period <= 0LL) {
+		this->period = 10000000LL;
+	}
+
+	this->epoch = current_monotonic_100nanoseconds();
+}
+
+TCPPollScheduler::~TCPPollScheduler() {
+	while (!this->devices.empty()) {
+		TCPPollTask* task = this->devices.front();
+
+		this->wheel->cancel(task);
+		this->devices.pop_front();
+		delete task;
+	}
+}
+
+void TCPPollScheduler::push_connection(ITCPConnection* device) {
+	TCPPollTask* task = new TCPPollTask(this, device);
+
+	this->section.lock();
+	this->devices.push_back(task);
+	this->respread();
+	this->section.unlock();
+
+	task->start();
+}
+
+bool TCPPollScheduler::remove_connection(ITCPConnection* device) {
+	TCPPollTask* task = nullptr;
+	bool deferred = false;
+
+	this->section.lock();
+	for (auto it = this->devices.begin(); it != this->devices.end(); it++) {
+		if ((*it)->device == device) {
+			task = (*it);
+			this->devices.erase(it);
+			this->respread();
+
+			// the task is polling right on this thread, it deletes itself once the poll returns
+			if (task->firing_thread == std::this_thread::get_id()) {
+				task->dead = true;
+				deferred = true;
+			}
+
+			break;
+		}
+	}
+	this->section.unlock();
+
+	if ((task != nullptr) && (!deferred)) {
+		this->wheel->cancel(task);
+		delete task;
+	}
+
+	return (task != nullptr);
+}
+
+bool TCPPollScheduler::statistics(ITCPConnection* device, TCPPollStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+	bool found = false;
+
+	for (auto it = this->devices.begin(); it != this->devices.end(); it++) {
+		if ((*it)->device == device) {
+			(*stat) = (*it)->statistics;
+			found = true;
+			break;
+		}
+	}
+
+	return found;
+}
+
+long long TCPPollScheduler::period_milliseconds() {
+	return this->period / 10000LL;
+}
+
+void TCPPollScheduler::respread() {
+	long long count = (long long)(this->devices.size());
+	long long idx = 0LL;
+
+	for (auto it = this->devices.begin(); it != this->devices.end(); it++, idx++) {
+		(*it)->phase = this->period * idx / count;
+	}
+}
+
+/*************************************************************************************************/
+AdaptivePollRate::AdaptivePollRate(unsigned int stable_threshold)
+	: stable_threshold((stable_threshold > 0U) ? stable_threshold : 1U) {}
+
+void AdaptivePollRate::register_block(unsigned int block, long long min_cycles, long long max_cycles) {
+	std::unique_lock<std::mutex> guard(this->section);
+	AdaptivePollRate::Block* self = &this->blocks[block];
+
+	self->min_interval = ((min_cycles > 0LL) ? min_cycles : 1LL);
+	self->max_interval = ((max_cycles > self->min_interval) ? max_cycles : self->min_interval);
+	self->interval = self->min_interval;
+	self->last_poll = 0LL;
+	self->digest = 0ULL;
+	self->stable_count = 0U;
+	self->fresh = true;
+
+	self->statistics.interval = self->interval;
+	self->statistics.polls = 0LL;
+	self->statistics.changes = 0LL;
+	self->statistics.skips = 0LL;
+}
+
+void AdaptivePollRate::unregister_block(unsigned int block) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->blocks.erase(block);
+}
+
+void AdaptivePollRate::reset() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	// say, the connection is re-established
+	for (auto it = this->blocks.begin(); it != this->blocks.end(); it++) {
+		it->second.interval = it->second.min_interval;
+		it->second.stable_count = 0U;
+		it->second.fresh = true;
+		it->second.statistics.interval = it->second.interval;
+	}
+}
+
+bool AdaptivePollRate::is_due(unsigned int block, long long cycle) {
+	std::unique_lock<std::mutex> guard(this->section);
+	auto it = this->blocks.find(block);
+	bool due = true;
+
+	if (it != this->blocks.end()) {
+		AdaptivePollRate::Block* self = &it->second;
+
+		due = (self->fresh || (cycle < self->last_poll) || (cycle - self->last_poll >= self->interval));
+
+		if (due) {
+			self->last_poll = cycle;
+			self->statistics.polls++;
+		} else {
+			self->statistics.skips++;
+		}
+	}
+
+	return due;
+}
+
+bool AdaptivePollRate::feedback(unsigned int block, const uint8* data, size_t size) {
+	std::unique_lock<std::mutex> guard(this->section);
+	auto it = this->blocks.find(block);
+	bool changed = true;
+
+	if (it != this->blocks.end()) {
+		AdaptivePollRate::Block* self = &it->second;
+		unsigned long long digest = fnv1a_hash(data, size);
+
+		changed = (self->fresh || (digest != self->digest));
+
+		if (changed) {
+			if (!self->fresh) {
+				self->statistics.changes++;
+			}
+
+			self->interval = self->min_interval;
+			self->stable_count = 0U;
+		} else if ((++self->stable_count) >= this->stable_threshold) {
+			self->interval = ((self->interval < self->max_interval / 2LL) ? (self->interval * 2LL) : self->max_interval);
+			self->stable_count = 0U;
+		}
+
+		self->digest = digest;
+		self->fresh = false;
+		self->statistics.interval = self->interval;
+	}
+
+	return changed;
+}
+
+bool AdaptivePollRate::statistics(unsigned int block, AdaptivePollStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+	auto it = this->blocks.find(block);
+	bool found = (it != this->blocks.end());
+
+	if (found) {
+		(*stat) = it->second.statistics;
+	}
+
+	return found;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <map>
+
+#include "network/tcp.hpp"
+
+#include "timewheel.hpp"
+
+namespace WarGrey::SCADA {
+	class TCPPollTask;
+
+	private struct TCPPollStatistics {
+		long long polls;
+		long long overruns;
+		double last_jitter_ms;
+		double max_jitter_ms;
+		double mean_jitter_ms;
+	};
+
+	/** NOTE
+	 * Polls fire on absolute deadlines `epoch + phase + k * period` of the monotonic clock,
+	 *   hence late ticks do not accumulate into drifts, and missed cycles are counted as overruns instead of bunching.
+	 *
+	 * The period follows `make_timespan_from_rate()`, and devices are spread evenly across the period,
+	 *   `ITCPConnection::send_scheduled_request()` receives the cycle index, the period and the uptime in milliseconds.
+	 */
+	private class TCPPollScheduler {
+		friend class WarGrey::SCADA::TCPPollTask;
+
+	public:
+		virtual ~TCPPollScheduler() noexcept;
+		TCPPollScheduler(int rate, unsigned int shift = 1U, WarGrey::SCADA::TimingWheel* wheel = nullptr);
+
+	public:
+		void push_connection(WarGrey::SCADA::ITCPConnection* device);
+		bool remove_connection(WarGrey::SCADA::ITCPConnection* device); // safe to be called while polling the device
+
+	public:
+		bool statistics(WarGrey::SCADA::ITCPConnection* device, WarGrey::SCADA::TCPPollStatistics* stat);
+		long long period_milliseconds();
+
+	private:
+		void respread();
+
+	private:
+		std::mutex section;
+		std::deque<WarGrey::SCADA::TCPPollTask*> devices;
+		WarGrey::SCADA::TimingWheel* wheel;
+		long long epoch;
+		long long period;
+	};
+
+	/*********************************************************************************************/
+	private struct AdaptivePollStatistics {
+		long long interval;
+		long long polls;
+		long long changes;
+		long long skips;
+	};
+
+	/** NOTE
+	 * Intervals are counted in cycles of the scheduled requests, a block that changed is polled at its minimum interval
+	 *   at once, and a block that stays unchanged for `stable_threshold` polls in a row doubles its interval up to the maximum.
+	 *
+	 * Usage in `send_scheduled_request(count, ...)`:
+	 *   only request blocks that `is_due(block, count)`, and hand every response of them to `feedback()`.
+	 */
+	private class AdaptivePollRate {
+	public:
+		virtual ~AdaptivePollRate() noexcept {}
+		AdaptivePollRate(unsigned int stable_threshold = 4U);
+
+	public:
+		void register_block(unsigned int block, long long min_cycles, long long max_cycles);
+		void unregister_block(unsigned int block);
+		void reset();
+
+	public:
+		bool is_due(unsigned int block, long long cycle);
+		bool feedback(unsigned int block, const uint8* data, size_t size);
+		bool statistics(unsigned int block, WarGrey::SCADA::AdaptivePollStatistics* stat);
+
+	private:
+		struct Block {
+			long long min_interval;
+			long long max_interval;
+			long long interval;
+			long long last_poll;
+			unsigned long long digest;
+			unsigned int stable_count;
+			bool fresh;
+			WarGrey::SCADA::AdaptivePollStatistics statistics;
+		};
+
+	private:
+		std::mutex section;
+		std::map<unsigned int, WarGrey::SCADA::AdaptivePollRate::Block> blocks;
+		unsigned int stable_threshold;
+	};
+}
@@ -0,0 +1,105 @@
+#include <thread>
+
+#include "network/shard.hpp"
+
+#include "datum/hash.hpp"
+
+using namespace WarGrey::SCADA;
+
+/*************************************************************************************************/
+TCPShardPool::TCPShardPool(unsigned int shard_count, int rate, unsigned int shift, bool pinned) {
+	unsigned int processors = std::thread::hardware_concurrency();
+
+	if (processors == 0U) {
+		processors = 1U;
+	}
+
+	if (shard_count == 0U) {
+		shard_count = processors;
+	}
+
+	for (unsigned int idx = 0; idx < shard_count; idx++) {
+		TCPShardPool::Shard* shard = new TCPShardPool::Shard();
+
+		shard->loop = new TCPEventLoop();
+		shard->scheduler = new TCPPollScheduler(rate, shift, shard->loop->get_wheel());
+		shard->devices.store(0U);
+		shard->processor = idx % processors;
+		shard->pinned = (pinned && shard->loop->pin(shard->processor));
+
+		this->shards.push_back(shard);
+	}
+}
+
+TCPShardPool::~TCPShardPool() {
+	for (auto shard : this->shards) {
+		// the scheduler cancels its tasks on the wheel of the loop, on the thread of the loop
+		shard->loop->execute([=]() { delete shard->scheduler; });
+		delete shard->loop;
+		delete shard;
+	}
+}
+
+unsigned int TCPShardPool::shard_count() {
+	return (unsigned int)(this->shards.size());
+}
+
+unsigned int TCPShardPool::shard_of(Platform::String^ device_key) {
+	unsigned long long hash = fnv1a_offset_basis;
+
+	if (device_key != nullptr) {
+		hash = fnv1a_hash(device_key->Data(), device_key->Length() * sizeof(wchar_t));
+	}
+
+	return (unsigned int)(hash % this->shards.size());
+}
+
+TCPEventLoop* TCPShardPool::get_loop(unsigned int shard) {
+	return this->shards[shard % this->shards.size()]->loop;
+}
+
+TCPPollScheduler* TCPShardPool::get_scheduler(unsigned int shard) {
+	return this->shards[shard % this->shards.size()]->scheduler;
+}
+
+void TCPShardPool::schedule(unsigned int shard, ITCPConnection* device) {
+	TCPShardPool::Shard* self = this->shards[shard % this->shards.size()];
+
+	self->devices.fetch_add(1U);
+
+	// arming on the thread of the loop, otherwise the first poll may wait until the loop wakes up by itself
+	self->loop->post([=]() { self->scheduler->push_connection(device); });
+}
+
+bool TCPShardPool::unschedule(unsigned int shard, ITCPConnection* device) {
+	TCPShardPool::Shard* self = this->shards[shard % this->shards.size()];
+	bool found = false;
+
+	// after the device is pushed if it is still in the mailbox
+	self->loop->execute([&]() { found = self->scheduler->remove_connection(device); });
+
+	if (found) {
+		self->devices.fetch_sub(1U);
+	}
+
+	return found;
+}
+
+void TCPShardPool::post(unsigned int shard, std::function<void()> command) {
+	this->get_loop(shard)->post(command);
+}
+
+void TCPShardPool::broadcast(std::function<void(unsigned int shard)> command) {
+	for (unsigned int idx = 0; idx < this->shards.size(); idx++) {
+		this->shards[idx]->loop->post([=]() { command(idx); });
+	}
+}
+
+void TCPShardPool::statistics(unsigned int shard, TCPShardStatistics* stat) {
+	TCPShardPool::Shard* self = this->shards[shard % this->shards.size()];
+
+	stat->processor = self->processor;
+	stat->pinned = self->pinned;
+	stat->devices = self->devices.load();
+	self->loop->statistics(&stat->loop);
+}
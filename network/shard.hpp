@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <functional>
+
+#include "network/evloop.hpp"
+#include "network/poll.hpp"
+
+namespace WarGrey::SCADA {
+	private struct TCPShardStatistics {
+		unsigned int processor;
+		bool pinned;
+		size_t devices;
+		WarGrey::SCADA::TCPEventLoopStatistics loop;
+	};
+
+	/** NOTE
+	 * Devices are partitioned across shards, every shard is an event loop on its own thread (pinned to a core if possible)
+	 *   that owns the connections, the timers and the poll scheduler of its devices,
+	 *   so that shards share nothing but their mailboxes, which carry commands from other threads.
+	 *
+	 * A device should be constructed on `get_loop(shard_of(hostname))` and then `schedule`d on the same shard,
+	 *   its polls are fired on the thread of that shard. Devices should be destroyed before the pool.
+	 */
+	private class TCPShardPool {
+	public:
+		virtual ~TCPShardPool() noexcept;
+
+		/** NOTE
+		 * `shard_count` defaults to the number of logical processors,
+		 *   `rate` and `shift` are the ones of `TCPPollScheduler`.
+		 */
+		TCPShardPool(unsigned int shard_count = 0U, int rate = 1, unsigned int shift = 1U, bool pinned = true);
+
+	public:
+		unsigned int shard_count();
+		unsigned int shard_of(Platform::String^ device_key); // stable for the same key
+		WarGrey::SCADA::TCPEventLoop* get_loop(unsigned int shard);
+		WarGrey::SCADA::TCPPollScheduler* get_scheduler(unsigned int shard);
+
+	public:
+		void schedule(unsigned int shard, WarGrey::SCADA::ITCPConnection* device);
+		bool unschedule(unsigned int shard, WarGrey::SCADA::ITCPConnection* device); // no polls fired since then
+
+	public:
+		void post(unsigned int shard, std::function<void()> command);
+		void broadcast(std::function<void(unsigned int shard)> command);
+		void statistics(unsigned int shard, WarGrey::SCADA::TCPShardStatistics* stat);
+
+	private:
+		struct Shard {
+			WarGrey::SCADA::TCPEventLoop* loop;
+			WarGrey::SCADA::TCPPollScheduler* scheduler;
+			std::atomic<size_t> devices;
+			unsigned int processor;
+			bool pinned;
+		};
+
+	private:
+		std::vector<WarGrey::SCADA::TCPShardPool::Shard*> shards;
+	};
+}
@@ -1,63 +1,46 @@
 #include "network/tcp.hpp"
 
-using namespace WarGrey::SCADA;
+#include "timewheel.hpp"
 
-using namespace Windows::Foundation;
-using namespace Windows::UI::Xaml;
+using namespace WarGrey::SCADA;
 
 /*************************************************************************************************/
-namespace {
-	private ref class TCPKiller {
-	public:
-	internal:
-		TCPKiller(ITCPConnection* master) : master(master) {
-			this->timer = ref new DispatcherTimer();
-			this->timer->Tick += ref new EventHandler<Platform::Object^>(this, &TCPKiller::check_timeout);
-		}
-
-	public:
-		void set_timeout(long long ms) {
-			this->timeout = ms;
-
-			if (ms > 0) {
-				this->timer->Interval = make_timespan_from_milliseconds(ms);
-				this->timer->Start(); // starting or restarting
-				this->timer->Start(); // ensured restarting
-			} else {
-				this->timer->Stop();
-			}
-		}
-
-	public:
-		void check_timeout(Platform::Object^ whocares, Platform::Object^ useless) {
-			this->master->suicide_if_timeout(this->timeout);
-		}
-
-	private:
-		Windows::UI::Xaml::DispatcherTimer^ timer;
-		long long timeout;
+ITCPConnection::~ITCPConnection() {
+	// in case subclasses have not done it, no callbacks run after this
+	this->dispose();
 
-	private:
-		ITCPConnection* master;
-	};
+	if (this->killer != nullptr) {
+		delete this->killer;
+	}
 }
 
-/*************************************************************************************************/
-ITCPConnection::~ITCPConnection() {
-	this->set_suicide_timeout(0);
+void ITCPConnection::dispose() {
+	if (this->killer != nullptr) {
+		this->killer->dispose();
+	}
 }
 
 void ITCPConnection::set_suicide_timeout(long long ms) {
-	TCPKiller^ killer = ((this->killer == nullptr)
-		? (ref new TCPKiller(this))
-		: dynamic_cast<TCPKiller^>(this->killer));
+	if (this->killer == nullptr) {
+		this->killer = new TimingWheelRelay([this](long long now_ms) {
+			long long timeout = this->suicide_timeout.load();
 
-	killer->set_timeout(ms);
-	this->reset_heartbeat();
+			if (timeout > 0) {
+				this->suicide_if_timeout(timeout);
+				this->killer->arm(timeout);
+			}
+		}, this->wheel);
+	}
 
-	if (this->killer == nullptr) {
-		this->killer = killer;
+	this->suicide_timeout.store(ms);
+
+	if (ms > 0) {
+		this->killer->arm(ms); // starting or restarting
+	} else {
+		this->killer->cancel();
 	}
+
+	this->reset_heartbeat();
 }
 
 bool ITCPConnection::authorized() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <atomic>
 
 #include "datum/time.hpp"
 #include "datum/flonum.hpp"
@@ -8,13 +9,16 @@
 #include "syslog.hpp"
 
 namespace WarGrey::SCADA {
+	class TimingWheel;
+	class TimingWheelRelay;
+
 	private enum class TCPMode { Root, User, Debug, _ };
 	private enum class TCPType { PLC, GPS, AIS, _ };
 	
 	private class ITCPConnection abstract {
 	public:
 		virtual ~ITCPConnection() noexcept;
-		ITCPConnection(WarGrey::SCADA::TCPType type) : type(type) {}
+		ITCPConnection(WarGrey::SCADA::TCPType type, WarGrey::SCADA::TimingWheel* wheel = nullptr) : type(type), wheel(wheel) {}
 
 	public:
 		virtual Platform::String^ device_hostname() = 0;
@@ -42,10 +46,25 @@ namespace WarGrey::SCADA {
 	protected:
 		virtual void reset_heartbeat() = 0;
 
+	protected:
+		/** NOTE
+		 * The suicide timer fires on the thread that drives `wheel` if given,
+		 *   otherwise it is relayed to the thread that creates the connection if it is the UI thread,
+		 *   and connections created off the UI thread get it on the thread of the shared wheel,
+		 *   whereas it used to be a `DispatcherTimer` on the UI thread for all connections.
+		 *
+		 * `dispose()` cancels the timer and waits for the running callback, the destructor does it anyway,
+		 *   but by then the subclasses are gone, so classes that implement `suicide()` or `suicide_if_timeout()`
+		 *   should also `dispose()` first in their destructors.
+		 */
+		void dispose();
+
 	private:
 		WarGrey::SCADA::TCPMode mode = TCPMode::Root;
 		WarGrey::SCADA::TCPType type = TCPType::PLC;
-		Platform::Object^ killer;
+		WarGrey::SCADA::TimingWheel* wheel = nullptr;
+		WarGrey::SCADA::TimingWheelRelay* killer = nullptr;
+		std::atomic<long long> suicide_timeout { 0LL };
 	};
 
 	private class ITCPStateListener {
@@ -61,7 +80,11 @@ namespace WarGrey::SCADA {
 	template<class TCPStateListener>
 	private class ITCPFeedBackConnection abstract : public WarGrey::SCADA::ITCPConnection {
 	public:
-		ITCPFeedBackConnection(WarGrey::SCADA::TCPType type) : ITCPConnection(type) {}
+		virtual ~ITCPFeedBackConnection() noexcept {
+			this->dispose();
+		}
+
+		ITCPFeedBackConnection(WarGrey::SCADA::TCPType type, WarGrey::SCADA::TimingWheel* wheel = nullptr) : ITCPConnection(type, wheel) {}
 
 	public:
 		void push_status_listener(TCPStateListener* listener) {
@@ -95,7 +118,7 @@ namespace WarGrey::SCADA {
 				(*it)->on_receive_data(this, bytes, span_ms, timestamp);
 			}
 
-			this->last_heartbeat = (long long)(flround(timestamp));
+			this->last_heartbeat.store(current_monotonic_milliseconds());
 		}
 
 		void notify_data_confirmed(long long bytes, double span_ms) {
@@ -108,9 +131,9 @@ namespace WarGrey::SCADA {
 
 	public:
 		void suicide_if_timeout(long long timeout) override {
-			long long now = current_milliseconds();
+			long long now = current_monotonic_milliseconds();
 
-			if ((now - this->last_heartbeat) > timeout) {
+			if ((now - this->last_heartbeat.load()) > timeout) {
 				this->suicide();
 				this->reset_heartbeat();
 			}
@@ -118,14 +141,14 @@ namespace WarGrey::SCADA {
 
 	protected:
 		void reset_heartbeat() override {
-			this->last_heartbeat = current_milliseconds();
+			this->last_heartbeat.store(current_monotonic_milliseconds());
 		}
 
 	protected:
 		std::list<TCPStateListener*> listeners;
 
 	private:
-		long long last_heartbeat;
+		std::atomic<long long> last_heartbeat { 0LL }; // touched by the owner and the thread of the connection
 	};
 
 	typedef WarGrey::SCADA::ITCPFeedBackConnection<WarGrey::SCADA::ITCPStateListener> ITCPStatedConnection;
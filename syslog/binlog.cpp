@@ -0,0 +1,231 @@
+#include <cstring>
+
+#include "syslog/binlog.hpp"
+#include "syslog/deferred.hpp"
+
+using namespace WarGrey::SCADA;
+
+static const char binlog_magic[4] = { 'W', 'G', 'B', 'L' };
+static const unsigned short binlog_format_version = 1U;
+static const unsigned int binlog_max_record_size = 16U * 1024U * 1024U;
+static const long long l00ns_s = 10000000LL;
+
+static Platform::String^ make_wstring(const std::wstring& src) {
+	return ref new Platform::String(src.c_str(), (unsigned int)(src.size()));
+}
+
+/*************************************************************************************************/
+void WarGrey::SCADA::binary_log_make_file_header(BinaryLogFileHeader* header, long long timepoint, long long span) {
+	memset(header, 0, sizeof(BinaryLogFileHeader));
+	memcpy(header->magic, binlog_magic, sizeof(binlog_magic));
+	header->version = binlog_format_version;
+	header->wchar_size = (unsigned short)(sizeof(wchar_t));
+	header->timepoint = timepoint;
+	header->span = span;
+}
+
+/*************************************************************************************************/
+BinaryLogReader::BinaryLogReader() : decoded(0ULL), skipped(0ULL) {
+	binary_log_make_file_header(&this->header, 0LL, 0LL);
+}
+
+BinaryLogReader::~BinaryLogReader() {
+	this->close();
+}
+
+bool BinaryLogReader::open(Platform::String^ path) {
+	bool okay = false;
+
+	this->close();
+
+	if (this->src.open(path->Data(), std::ios::in | std::ios::binary) != nullptr) {
+		std::streamsize size = this->src.sgetn(reinterpret_cast<char*>(&this->header), sizeof(BinaryLogFileHeader));
+
+		okay = ((size == std::streamsize(sizeof(BinaryLogFileHeader)))
+			&& (memcmp(this->header.magic, binlog_magic, sizeof(binlog_magic)) == 0)
+			&& (this->header.version == binlog_format_version)
+			&& (this->header.wchar_size == sizeof(wchar_t)));
+
+		if (!okay) {
+			this->close();
+		}
+	}
+
+	return okay;
+}
+
+bool BinaryLogReader::is_open() {
+	return this->src.is_open();
+}
+
+void BinaryLogReader::close() {
+	if (this->src.is_open()) {
+		this->src.close();
+	}
+
+	this->topics.clear();
+	this->templates.clear();
+}
+
+bool BinaryLogReader::read(BinaryLogEntry* entry, const BinaryLogFilter* filter) {
+	BinaryLogRecordHeader header;
+	bool found = false;
+
+	while (this->src.is_open() && (!found)) {
+		std::streamsize size = this->src.sgetn(reinterpret_cast<char*>(&header), sizeof(BinaryLogRecordHeader));
+
+		if ((size != std::streamsize(sizeof(BinaryLogRecordHeader)))
+			|| (header.size < sizeof(BinaryLogRecordHeader)) || (header.size > binlog_max_record_size)) {
+			// EOF, or the tail is being written or is truncated
+			break;
+		}
+
+		switch (BinaryLogRecordType(header.type)) {
+		case BinaryLogRecordType::Topic: case BinaryLogRecordType::Template: {
+			this->define(&header);
+		}; break;
+		case BinaryLogRecordType::Text: case BinaryLogRecordType::Arguments: {
+			if (!this->relevant(&header, filter)) {
+				this->src.pubseekoff(header.size - sizeof(BinaryLogRecordHeader), std::ios::cur, std::ios::in);
+				this->skipped++;
+			} else {
+				size_t body_size = header.size - sizeof(BinaryLogRecordHeader);
+
+				this->body.resize(body_size);
+
+				if (this->src.sgetn(reinterpret_cast<char*>(this->body.data()), body_size) == std::streamsize(body_size)) {
+					auto topic = this->topics.find(header.topic);
+
+					entry->timestamp = header.timestamp;
+					entry->level = Log(header.level);
+					entry->topic = ((topic == this->topics.end()) ? nullptr : make_wstring(topic->second));
+
+					if (BinaryLogRecordType(header.type) == BinaryLogRecordType::Text) {
+						entry->message = ref new Platform::String(reinterpret_cast<const wchar_t*>(this->body.data()),
+							(unsigned int)(body_size / sizeof(wchar_t)));
+					} else {
+						SyslogArguments args;
+						unsigned int template_id = 0U;
+						unsigned short args_size = 0U;
+						auto fmt = this->templates.end();
+
+						if (body_size >= sizeof(unsigned int) + sizeof(unsigned short)) {
+							memcpy(&template_id, this->body.data(), sizeof(unsigned int));
+							memcpy(&args_size, this->body.data() + sizeof(unsigned int), sizeof(unsigned short));
+							fmt = this->templates.find(template_id);
+						}
+
+						if ((fmt != this->templates.end()) && (args_size <= sizeof(args.pool))
+							&& (sizeof(unsigned int) + sizeof(unsigned short) + args_size <= body_size)) {
+							args.format = fmt->second.c_str();
+							args.size = args_size;
+							memcpy(args.pool, this->body.data() + sizeof(unsigned int) + sizeof(unsigned short), args_size);
+							entry->message = syslog_render_arguments(&args);
+						} else {
+							entry->message = "#<corrupted record>";
+						}
+					}
+
+					this->decoded++;
+					found = true;
+				} else {
+					break;
+				}
+			}
+		}; break;
+		default: { // unknown records from future versions
+			this->src.pubseekoff(header.size - sizeof(BinaryLogRecordHeader), std::ios::cur, std::ios::in);
+		}
+		}
+	}
+
+	return found;
+}
+
+bool BinaryLogReader::overlaps(const BinaryLogFilter* filter) {
+	bool overlapped = true;
+
+	if ((filter != nullptr) && (this->header.span > 0LL)) {
+		long long start = this->header.timepoint * l00ns_s;
+		long long end = (this->header.timepoint + this->header.span) * l00ns_s;
+
+		overlapped = ((end > filter->since) && ((filter->until <= 0LL) || (start < filter->until)));
+	}
+
+	return overlapped;
+}
+
+long long BinaryLogReader::file_timepoint() {
+	return this->header.timepoint;
+}
+
+long long BinaryLogReader::file_span() {
+	return this->header.span;
+}
+
+unsigned long long BinaryLogReader::decoded_count() {
+	return this->decoded;
+}
+
+unsigned long long BinaryLogReader::skipped_count() {
+	return this->skipped;
+}
+
+/*************************************************************************************************/
+bool BinaryLogReader::relevant(const BinaryLogRecordHeader* header, const BinaryLogFilter* filter) {
+	bool okay = true;
+
+	if (filter != nullptr) {
+		okay = ((header->level >= (unsigned char)(filter->level))
+			&& (header->timestamp >= filter->since)
+			&& ((filter->until <= 0LL) || (header->timestamp < filter->until)));
+
+		if (okay && (filter->topic != nullptr)) {
+			auto topic = this->topics.find(header->topic);
+
+			okay = ((topic != this->topics.end()) && (topic->second.compare(filter->topic->Data()) == 0));
+		}
+	}
+
+	return okay;
+}
+
+void BinaryLogReader::define(const BinaryLogRecordHeader* header) {
+	size_t body_size = header->size - sizeof(BinaryLogRecordHeader);
+
+	this->body.resize(body_size);
+
+	if (this->src.sgetn(reinterpret_cast<char*>(this->body.data()), body_size) == std::streamsize(body_size)) {
+		const unsigned char* body = this->body.data();
+
+		if (BinaryLogRecordType(header->type) == BinaryLogRecordType::Topic) {
+			this->topics[header->topic].assign(reinterpret_cast<const wchar_t*>(body), body_size / sizeof(wchar_t));
+		} else if (body_size >= sizeof(unsigned int)) {
+			unsigned int id = 0U;
+
+			memcpy(&id, body, sizeof(unsigned int));
+			this->templates[id].assign(reinterpret_cast<const wchar_t*>(body + sizeof(unsigned int)),
+				(body_size - sizeof(unsigned int)) / sizeof(wchar_t));
+		}
+	}
+}
+
+/*************************************************************************************************/
+size_t WarGrey::SCADA::binary_log_query(const std::list<Platform::String^>& paths, const BinaryLogFilter& filter
+	, std::function<bool(BinaryLogEntry&)> on_entry) {
+	BinaryLogReader reader;
+	BinaryLogEntry entry;
+	size_t count = 0;
+	bool going = true;
+
+	for (auto it = paths.begin(); going && (it != paths.end()); it++) {
+		if (reader.open((*it)) && reader.overlaps(&filter)) {
+			while (going && reader.read(&entry, &filter)) {
+				count++;
+				going = on_entry(entry);
+			}
+		}
+	}
+
+	return count;
+}
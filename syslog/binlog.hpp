@@ -0,0 +1,103 @@
+#pragma once
+
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+
+#include "syslog/logging.hpp"
+
+namespace WarGrey::SCADA {
+	private enum class BinaryLogRecordType { Topic = 1, Template = 2, Text = 3, Arguments = 4 };
+
+	/** NOTE
+	 * A binary log file starts with a 32-byte header (magic "WGBL", version, size of wchar_t, rotation timepoint and span in seconds),
+	 *   followed by records that all start with the following 16-byte header, `size` includes the header itself.
+	 *
+	 * `Topic` records define `topic` ids, `Template` records define template ids by a `uint32` id followed by the format,
+	 *   `Text` records carry the formatted message, and `Arguments` records carry a template id, a `uint16` size and
+	 *   the captured arguments (see `syslog_capture_arguments()`), so that the message is formatted only when decoding.
+	 *
+	 * Ids are defined before their first use in each file, and the later definitions override the earlier ones,
+	 *   hence files are decoded independently and sequentially.
+	 */
+	private struct BinaryLogRecordHeader {
+		unsigned int size;
+		unsigned char type;
+		unsigned char level;
+		unsigned short topic;
+		long long timestamp;
+	};
+
+	private struct BinaryLogFileHeader {
+		char magic[4];
+		unsigned short version;
+		unsigned short wchar_size;
+		long long timepoint;
+		long long span;
+		long long reserved;
+	};
+
+	void binary_log_make_file_header(WarGrey::SCADA::BinaryLogFileHeader* header, long long timepoint_s, long long span_s);
+
+	/*********************************************************************************************/
+	private struct BinaryLogFilter {
+		long long since = 0LL;      // 100ns, inclusive
+		long long until = 0LL;      // 100ns, exclusive, non-positive means endless
+		WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug;
+		Platform::String^ topic = nullptr;
+	};
+
+	private struct BinaryLogEntry {
+		long long timestamp;
+		WarGrey::SCADA::Log level;
+		Platform::String^ topic;
+		Platform::String^ message;
+	};
+
+	private class BinaryLogReader {
+	public:
+		virtual ~BinaryLogReader() noexcept;
+		BinaryLogReader();
+
+	public:
+		bool open(Platform::String^ path);
+		bool is_open();
+		void close();
+
+	public:
+		/** NOTE
+		 * Irrelevant records are skipped by their headers, only definitions and matched records are decoded.
+		 */
+		bool read(WarGrey::SCADA::BinaryLogEntry* entry, const WarGrey::SCADA::BinaryLogFilter* filter = nullptr);
+		bool overlaps(const WarGrey::SCADA::BinaryLogFilter* filter);
+
+	public:
+		long long file_timepoint();
+		long long file_span();
+		unsigned long long decoded_count();
+		unsigned long long skipped_count();
+
+	private:
+		bool relevant(const WarGrey::SCADA::BinaryLogRecordHeader* header, const WarGrey::SCADA::BinaryLogFilter* filter);
+		void define(const WarGrey::SCADA::BinaryLogRecordHeader* header);
+
+	private:
+		std::filebuf src;
+		WarGrey::SCADA::BinaryLogFileHeader header;
+		std::map<unsigned short, std::wstring> topics;
+		std::map<unsigned int, std::wstring> templates;
+		std::vector<unsigned char> body;
+		unsigned long long decoded;
+		unsigned long long skipped;
+	};
+
+	/** NOTE
+	 * Files that do not overlap the time range of the filter are skipped by their file headers.
+	 * Return false in `on_entry` to stop the query, the number of matched entries is returned.
+	 */
+	size_t binary_log_query(const std::list<Platform::String^>& paths, const WarGrey::SCADA::BinaryLogFilter& filter,
+		std::function<bool(WarGrey::SCADA::BinaryLogEntry&)> on_entry);
+}
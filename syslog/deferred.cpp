@@ -0,0 +1,385 @@
+#include <cwchar>
+#include <cstring>
+
+#include "syslog/deferred.hpp"
+
+using namespace WarGrey::SCADA;
+
+namespace {
+	private enum class ArgType { Percent, Int, Long, LongLong, SizeT, Double, LongDouble, Pointer, NarrowString, WideString, Invalid };
+
+	private struct ConversionSpec {
+		size_t start;
+		size_t end;
+		unsigned int stars;
+		bool precision_star;
+		long long precision;
+		ArgType type;
+	};
+}
+
+static const size_t slot_size = 8U;
+static const size_t max_spec_length = 31U;
+static const unsigned int null_string = 0xFFFFFFFFU;
+
+static inline bool is_digit(wchar_t ch) {
+	return ((ch >= L'0') && (ch <= L'9'));
+}
+
+static bool next_conversion(const wchar_t* fmt, size_t* idx, ConversionSpec* spec) {
+	const wchar_t* percent = wcschr(fmt + (*idx), L'%');
+	bool found = (percent != nullptr);
+
+	if (found) {
+		size_t i = percent - fmt + 1;
+		wchar_t length = L'\0';
+		wchar_t ch = L'\0';
+
+		spec->start = i - 1;
+		spec->stars = 0U;
+		spec->precision_star = false;
+		spec->precision = -1LL;
+		spec->type = ArgType::Invalid;
+
+		if (fmt[i] == L'%') {
+			spec->type = ArgType::Percent;
+			i++;
+		} else {
+			while ((fmt[i] == L'-') || (fmt[i] == L'+') || (fmt[i] == L' ') || (fmt[i] == L'#') || (fmt[i] == L'0')) i++;
+
+			if (fmt[i] == L'*') {
+				spec->stars++;
+				i++;
+			} else {
+				while (is_digit(fmt[i])) i++;
+			}
+
+			if (fmt[i] == L'.') {
+				i++;
+				spec->precision = 0LL;
+
+				if (fmt[i] == L'*') {
+					spec->stars++;
+					spec->precision_star = true;
+					i++;
+				} else {
+					while (is_digit(fmt[i])) {
+						spec->precision = spec->precision * 10LL + (fmt[i] - L'0');
+						i++;
+					}
+				}
+			}
+
+			switch (fmt[i]) {
+			case L'h': length = ((fmt[i + 1] == L'h') ? L'H' : L'h'); i += ((length == L'H') ? 2 : 1); break;
+			case L'l': length = ((fmt[i + 1] == L'l') ? L'q' : L'l'); i += ((length == L'q') ? 2 : 1); break;
+			case L'j': case L'q': length = L'q'; i++; break;
+			case L'z': case L't': length = L'z'; i++; break;
+			case L'L': case L'w': length = fmt[i]; i++; break;
+			case L'I': {
+				if ((fmt[i + 1] == L'6') && (fmt[i + 2] == L'4')) {
+					length = L'q';
+					i += 3;
+				} else if ((fmt[i + 1] == L'3') && (fmt[i + 2] == L'2')) {
+					length = L'\0';
+					i += 3;
+				} else {
+					length = L'z';
+					i += 1;
+				}
+			}; break;
+			}
+
+			ch = fmt[i];
+
+			switch (ch) {
+			case L'd': case L'i': case L'u': case L'o': case L'x': case L'X': {
+				switch (length) {
+				case L'l': spec->type = ArgType::Long; break;
+				case L'q': spec->type = ArgType::LongLong; break;
+				case L'z': spec->type = ArgType::SizeT; break;
+				default: spec->type = ArgType::Int;
+				}
+			}; break;
+			case L'c': case L'C': spec->type = ArgType::Int; break;
+			case L'e': case L'E': case L'f': case L'F': case L'g': case L'G': case L'a': case L'A': {
+				spec->type = ((length == L'L') ? ArgType::LongDouble : ArgType::Double);
+			}; break;
+			case L'p': spec->type = ArgType::Pointer; break;
+			case L's': spec->type = ((length == L'h') ? ArgType::NarrowString : ArgType::WideString); break;
+			case L'S': spec->type = (((length == L'l') || (length == L'w')) ? ArgType::WideString : ArgType::NarrowString); break;
+			default: /* `%n`, `%Z` and unknowns */; break;
+			}
+
+			if (ch != L'\0') {
+				i++;
+			}
+		}
+
+		spec->end = i;
+		(*idx) = i;
+
+		if ((spec->end - spec->start) > max_spec_length) {
+			spec->type = ArgType::Invalid;
+		}
+	}
+
+	return found;
+}
+
+/*************************************************************************************************/
+template<typename T>
+static bool pool_write(SyslogArguments* args, T value) {
+	bool okay = (args->size + slot_size <= sizeof(args->pool));
+
+	if (okay) {
+		memcpy(args->pool + args->size, &value, sizeof(T));
+		args->size = (unsigned short)(args->size + slot_size);
+	}
+
+	return okay;
+}
+
+template<typename C>
+static bool pool_write_string(SyslogArguments* args, const C* src, long long precision) {
+	unsigned int length = null_string;
+	bool okay = false;
+
+	if (src != nullptr) {
+		length = 0U;
+
+		while (((precision < 0LL) || (length < precision)) && (src[length] != 0)) {
+			length++;
+		}
+	}
+
+	if (pool_write(args, length)) {
+		if (length == null_string) {
+			okay = true;
+		} else {
+			size_t size = (length + 1U) * sizeof(C);
+			size_t padded = (size + slot_size - 1U) / slot_size * slot_size;
+
+			okay = (args->size + padded <= sizeof(args->pool));
+
+			if (okay) {
+				memcpy(args->pool + args->size, src, length * sizeof(C));
+				memset(args->pool + args->size + length * sizeof(C), 0, padded - length * sizeof(C));
+				args->size = (unsigned short)(args->size + padded);
+			}
+		}
+	}
+
+	return okay;
+}
+
+/** NOTE
+ * Readers never go beyond `args->size`, the `offset` moves past it instead if the arguments are corrupted,
+ *   say, loaded from a damaged binary log, and the caller should check it after each conversion.
+ */
+template<typename T>
+static T pool_read(const SyslogArguments* args, size_t* offset) {
+	T value = T();
+
+	if ((*offset) + sizeof(T) <= args->size) {
+		memcpy(&value, args->pool + (*offset), sizeof(T));
+	}
+
+	(*offset) += slot_size;
+
+	return value;
+}
+
+template<typename C>
+static const C* pool_read_string(const SyslogArguments* args, size_t* offset) {
+	static const C corrupted[1] = { C(0) };
+	unsigned int length = pool_read<unsigned int>(args, offset);
+	const C* str = nullptr;
+
+	if (length != null_string) {
+		size_t size = (size_t(length) + 1U) * sizeof(C);
+
+		if ((length < args->size) && ((*offset) + size <= args->size)) {
+			str = reinterpret_cast<const C*>(args->pool + (*offset));
+
+			if (str[length] != C(0)) {
+				str = corrupted;
+				(*offset) = args->size;
+			}
+
+			(*offset) += (size + slot_size - 1U) / slot_size * slot_size;
+		} else {
+			str = corrupted;
+			(*offset) = args->size + slot_size;
+		}
+	}
+
+	return str;
+}
+
+template<typename T>
+static int render_conversion(wchar_t* dest, size_t size, const wchar_t* spec, unsigned int stars, int* star_values, T value) {
+	int status = -1;
+
+	switch (stars) {
+	case 0: status = swprintf(dest, size, spec, value); break;
+	case 1: status = swprintf(dest, size, spec, star_values[0], value); break;
+	default: status = swprintf(dest, size, spec, star_values[0], star_values[1], value); break;
+	}
+
+	return status;
+}
+
+/*************************************************************************************************/
+bool WarGrey::SCADA::syslog_capture_arguments(SyslogArguments* args, const wchar_t* format, va_list argl) {
+	ConversionSpec spec;
+	size_t idx = 0;
+	bool okay = (format != nullptr);
+
+	args->format = format;
+	args->size = 0U;
+
+	while (okay && next_conversion(format, &idx, &spec)) {
+		int star_values[2] = { 0, 0 };
+
+		for (unsigned int s = 0; okay && (s < spec.stars); s++) {
+			star_values[s] = va_arg(argl, int);
+			okay = pool_write(args, star_values[s]);
+		}
+
+		if (spec.precision_star) {
+			spec.precision = star_values[spec.stars - 1U];
+		}
+
+		if (okay) {
+			switch (spec.type) {
+			case ArgType::Percent: break;
+			case ArgType::Int: okay = pool_write(args, va_arg(argl, int)); break;
+			case ArgType::Long: okay = pool_write(args, va_arg(argl, long)); break;
+			case ArgType::LongLong: okay = pool_write(args, va_arg(argl, long long)); break;
+			case ArgType::SizeT: okay = pool_write(args, va_arg(argl, size_t)); break;
+			case ArgType::Double: okay = pool_write(args, va_arg(argl, double)); break;
+			case ArgType::LongDouble: okay = pool_write(args, double(va_arg(argl, long double))); break;
+			case ArgType::Pointer: okay = pool_write(args, va_arg(argl, void*)); break;
+			case ArgType::NarrowString: okay = pool_write_string(args, va_arg(argl, const char*), spec.precision); break;
+			case ArgType::WideString: okay = pool_write_string(args, va_arg(argl, const wchar_t*), spec.precision); break;
+			default: okay = false; break;
+			}
+		}
+	}
+
+	return okay;
+}
+
+bool WarGrey::SCADA::syslog_capture_arguments(SyslogArguments* args, const wchar_t* format, ...) {
+	va_list argl;
+	bool okay = false;
+
+	va_start(argl, format);
+	okay = syslog_capture_arguments(args, format, argl);
+	va_end(argl);
+
+	return okay;
+}
+
+int WarGrey::SCADA::syslog_render_arguments(const SyslogArguments* args, wchar_t* dest, size_t size) {
+	const wchar_t* format = args->format;
+	ConversionSpec spec;
+	size_t idx = 0;
+	size_t offset = 0;
+	size_t pos = 0;
+	bool okay = ((size > 0) && (args->size <= sizeof(args->pool)));
+
+	while (okay) {
+		size_t literal_start = idx;
+		bool more = next_conversion(format, &idx, &spec);
+		size_t literal_size = (more ? spec.start : (literal_start + wcslen(format + literal_start))) - literal_start;
+
+		okay = (pos + literal_size < size);
+
+		if (okay) {
+			wmemcpy(dest + pos, format + literal_start, literal_size);
+			pos += literal_size;
+		}
+
+		if (okay && more) {
+			wchar_t spec_format[max_spec_length + 1];
+			size_t spec_size = spec.end - spec.start;
+			int star_values[2] = { 0, 0 };
+			wchar_t* target = dest + pos;
+			size_t room = size - pos;
+			int status = -1;
+
+			wmemcpy(spec_format, format + spec.start, spec_size);
+			spec_format[spec_size] = L'\0';
+
+			for (unsigned int s = 0; s < spec.stars; s++) {
+				star_values[s] = pool_read<int>(args, &offset);
+			}
+
+			switch (spec.type) {
+			case ArgType::Percent: {
+				if (room > 1) {
+					target[0] = L'%';
+					status = 1;
+				}
+			}; break;
+			case ArgType::Int: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<int>(args, &offset)); break;
+			case ArgType::Long: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<long>(args, &offset)); break;
+			case ArgType::LongLong: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<long long>(args, &offset)); break;
+			case ArgType::SizeT: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<size_t>(args, &offset)); break;
+			case ArgType::Double: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<double>(args, &offset)); break;
+			case ArgType::LongDouble: status = render_conversion(target, room, spec_format, spec.stars, star_values, (long double)(pool_read<double>(args, &offset))); break;
+			case ArgType::Pointer: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read<void*>(args, &offset)); break;
+			case ArgType::NarrowString: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read_string<char>(args, &offset)); break;
+			case ArgType::WideString: status = render_conversion(target, room, spec_format, spec.stars, star_values, pool_read_string<wchar_t>(args, &offset)); break;
+			default: /* never happens for captured arguments */; break;
+			}
+
+			okay = ((status >= 0) && (offset <= args->size));
+
+			if (okay) {
+				pos += status;
+			}
+		}
+
+		if (!more) {
+			break;
+		}
+	}
+
+	if (size > 0) {
+		dest[pos] = L'\0';
+	}
+
+	return (okay ? int(pos) : -1);
+}
+
+Platform::String^ WarGrey::SCADA::syslog_render_arguments(const SyslogArguments* args) {
+	const size_t DEFAULT_POOL_SIZE = 1024;
+	const size_t MAX_POOL_SIZE = 65536;
+	wchar_t wpool[DEFAULT_POOL_SIZE];
+	wchar_t* pool = wpool;
+	size_t size = DEFAULT_POOL_SIZE;
+	int length = syslog_render_arguments(args, pool, size);
+	Platform::String^ message = nullptr;
+
+	while ((length < 0) && (size < MAX_POOL_SIZE)) {
+		if (pool != wpool) {
+			delete[] pool;
+		}
+
+		size *= 2;
+		pool = new wchar_t[size];
+		length = syslog_render_arguments(args, pool, size);
+	}
+
+	// the partial message is better than nothing
+	message = ref new Platform::String(pool, (unsigned int)((length >= 0) ? length : wcslen(pool)));
+
+	if (pool != wpool) {
+		delete[] pool;
+	}
+
+	return message;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdarg>
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * Arguments are stored in the order of conversions of the format, every scalar takes an 8-byte slot,
+	 *   and every string is copied inline as a 4-byte length followed by its characters.
+	 *
+	 * The format itself is not copied, it must outlive the record (say, a string literal).
+	 */
+	private struct SyslogArguments {
+		const wchar_t* format;
+		unsigned short size;
+		unsigned char pool[230];
+	};
+
+	/** WARNING
+	 * Following the default MSVC wide specifiers, `%s` and `%c` take wide characters, `%S`, `%hs` and `%hc` take narrow ones.
+	 * Capturing fails if the arguments do not fit in the pool, or the format contains `%n` or unknown conversions,
+	 *   the caller should format the message eagerly instead.
+	 */
+	bool syslog_capture_arguments(WarGrey::SCADA::SyslogArguments* args, const wchar_t* format, va_list argl);
+	bool syslog_capture_arguments(WarGrey::SCADA::SyslogArguments* args, const wchar_t* format, ...);
+
+	int syslog_render_arguments(const WarGrey::SCADA::SyslogArguments* args, wchar_t* dest, size_t size);
+	Platform::String^ syslog_render_arguments(const WarGrey::SCADA::SyslogArguments* args);
+}
@@ -0,0 +1,129 @@
+#include "syslog/limiter.hpp"
+
+#include "datum/hash.hpp"
+
+using namespace WarGrey::SCADA;
+
+/*************************************************************************************************/
+unsigned long long WarGrey::SCADA::syslog_message_hash(Platform::String^ message) {
+	unsigned long long hash = fnv1a_offset_basis;
+
+	if (message != nullptr) {
+		hash = fnv1a_hash(message->Data(), message->Length() * sizeof(wchar_t));
+	}
+
+	return hash;
+}
+
+unsigned long long WarGrey::SCADA::syslog_message_hash(const SyslogArguments* args) {
+	// formats are literals, their addresses are as good as their contents
+	unsigned long long hash = fnv1a_hash(&args->format, sizeof(args->format));
+
+	return fnv1a_hash(args->pool, args->size, hash);
+}
+
+/*************************************************************************************************/
+SyslogLimiter::SyslogLimiter(double rate, double burst, bool collapse, long long repeat_window_ms)
+	: rate(rate), burst((burst >= 1.0) ? burst : ((rate >= 1.0) ? rate : 1.0)), collapse(collapse), repeat_window(repeat_window_ms) {
+	this->counters.admitted = 0ULL;
+	this->counters.limited = 0ULL;
+	this->counters.collapsed = 0ULL;
+}
+
+bool SyslogLimiter::admit(Platform::String^ topic, Log level, unsigned long long hash, long long now_ms, SyslogLimiterNote* note) {
+	std::unique_lock<std::mutex> guard(this->section);
+	std::wstring key = ((topic == nullptr) ? std::wstring() : std::wstring(topic->Data(), topic->Length()));
+	auto it = this->buckets.find(key);
+	SyslogLimiter::Bucket* self = nullptr;
+	bool admitted = true;
+
+	if (it != this->buckets.end()) {
+		self = &it->second;
+	} else {
+		self = &this->buckets[key];
+		self->topic = topic;
+		self->tokens = this->burst;
+		self->refilled_ms = now_ms;
+		self->last_hash = 0ULL;
+		self->last_level = level;
+		self->has_last = false;
+		self->repeated = 0ULL;
+		self->repeat_since_ms = now_ms;
+		self->limited = 0ULL;
+	}
+
+	note->level = self->last_level;
+	note->repeated = 0ULL;
+	note->limited = 0ULL;
+
+	if (this->collapse && self->has_last && (self->last_hash == hash) && (self->last_level == level)) {
+		self->repeated++;
+		this->counters.collapsed++;
+		admitted = false;
+
+		if (now_ms - self->repeat_since_ms >= this->repeat_window) {
+			note->repeated = self->repeated;
+			self->repeated = 0ULL;
+			self->repeat_since_ms = now_ms;
+		}
+	} else {
+		if (self->repeated > 0ULL) {
+			note->repeated = self->repeated;
+			self->repeated = 0ULL;
+		}
+
+		if (this->rate > 0.0) {
+			self->tokens += double(now_ms - self->refilled_ms) * this->rate / 1000.0;
+			self->refilled_ms = now_ms;
+
+			if (self->tokens > this->burst) {
+				self->tokens = this->burst;
+			}
+
+			if (self->tokens < 1.0) {
+				self->limited++;
+				this->counters.limited++;
+				admitted = false;
+			} else {
+				self->tokens -= 1.0;
+			}
+		}
+
+		if (admitted) {
+			note->limited = self->limited;
+			self->limited = 0ULL;
+			self->last_hash = hash;
+			self->last_level = level;
+			self->has_last = true;
+			self->repeat_since_ms = now_ms;
+			this->counters.admitted++;
+		}
+	}
+
+	return admitted;
+}
+
+void SyslogLimiter::drain(std::function<void(Platform::String^, SyslogLimiterNote&)> report) {
+	std::unique_lock<std::mutex> guard(this->section);
+	SyslogLimiterNote note;
+
+	for (auto it = this->buckets.begin(); it != this->buckets.end(); it++) {
+		SyslogLimiter::Bucket* self = &it->second;
+
+		if ((self->repeated > 0ULL) || (self->limited > 0ULL)) {
+			note.level = self->last_level;
+			note.repeated = self->repeated;
+			note.limited = self->limited;
+			self->repeated = 0ULL;
+			self->limited = 0ULL;
+
+			report(self->topic, note);
+		}
+	}
+}
+
+void SyslogLimiter::statistics(SyslogLimiterStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	(*stat) = this->counters;
+}
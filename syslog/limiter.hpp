@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <functional>
+
+#include "syslog/logging.hpp"
+#include "syslog/deferred.hpp"
+
+namespace WarGrey::SCADA {
+	private struct SyslogLimiterNote {
+		WarGrey::SCADA::Log level;
+		unsigned long long repeated;
+		unsigned long long limited;
+	};
+
+	private struct SyslogLimiterStatistics {
+		unsigned long long admitted;
+		unsigned long long limited;
+		unsigned long long collapsed;
+	};
+
+	unsigned long long syslog_message_hash(Platform::String^ message);
+	unsigned long long syslog_message_hash(const WarGrey::SCADA::SyslogArguments* args);
+
+	/** NOTE
+	 * Every topic owns a token bucket refilled at `rate` tokens per second up to `burst` tokens,
+	 *   and a message that is identical to the previous one of the same topic (by level and hash) is collapsed without costing a token.
+	 *
+	 * The suppressed volume is reported through `SyslogLimiterNote`s when the next distinct message is admitted,
+	 *   or every `repeat_window_ms` during a long storm of duplicates, or when the limiter is drained.
+	 */
+	private class SyslogLimiter {
+	public:
+		virtual ~SyslogLimiter() noexcept {}
+		SyslogLimiter(double rate, double burst, bool collapse, long long repeat_window_ms = 30000LL);
+
+	public:
+		bool admit(Platform::String^ topic, WarGrey::SCADA::Log level, unsigned long long hash, long long now_ms,
+			WarGrey::SCADA::SyslogLimiterNote* note);
+		void drain(std::function<void(Platform::String^, WarGrey::SCADA::SyslogLimiterNote&)> report);
+		void statistics(WarGrey::SCADA::SyslogLimiterStatistics* stat);
+
+	private:
+		struct Bucket {
+			Platform::String^ topic;
+			double tokens;
+			long long refilled_ms;
+			unsigned long long last_hash;
+			WarGrey::SCADA::Log last_level;
+			bool has_last;
+			unsigned long long repeated;
+			long long repeat_since_ms;
+			unsigned long long limited;
+		};
+
+	private:
+		std::mutex section;
+		std::map<std::wstring, WarGrey::SCADA::SyslogLimiter::Bucket> buckets;
+		WarGrey::SCADA::SyslogLimiterStatistics counters;
+
+	private:
+		double rate;
+		double burst;
+		bool collapse;
+		long long repeat_window;
+	};
+}
@@ -1,35 +1,120 @@
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "logging.hpp"
+#include "syslog/queue.hpp"
+#include "syslog/limiter.hpp"
+#include "syslog/metrics.hpp"
 
 #include "datum/string.hpp"
 #include "datum/time.hpp"
 
 using namespace WarGrey::SCADA;
 
+namespace WarGrey::SCADA {
+	private struct SyslogRoute {
+		WarGrey::SCADA::ISyslogReceiver* receiver;
+		WarGrey::SCADA::Log level;
+	};
+
+	private struct SyslogRoutes {
+		unsigned long long generation;
+		WarGrey::SCADA::Log floor; // the minimum level among all receivers
+		std::vector<WarGrey::SCADA::SyslogRoute> own;
+		std::vector<WarGrey::SCADA::SyslogRoute> untopic;
+		std::map<std::wstring, std::vector<WarGrey::SCADA::SyslogRoute>> topics;
+	};
+}
+
+// guard the receivers of all loggers
+static std::mutex routing_section;
+static std::atomic<unsigned long long> routing_generation(1ULL);
+
+static Platform::String^ vformat_message(const wchar_t* fmt, va_list argl) {
+	const int DEFAULT_POOL_SIZE = 1024;
+	wchar_t wpool[DEFAULT_POOL_SIZE];
+	int size = DEFAULT_POOL_SIZE;
+	wchar_t* pool = wpool;
+	Platform::String^ message = nullptr;
+
+	while (message == nullptr) {
+		va_list args;
+		int status = 0;
+
+		va_copy(args, argl);
+		status = vswprintf(pool, size, fmt, args);
+		va_end(args);
+
+		if ((status >= 0) || (size >= 65536)) {
+			message = ref new Platform::String(pool, (unsigned int)((status >= 0) ? status : wcslen(pool)));
+		} else {
+			if (pool != wpool) {
+				delete[] pool;
+			}
+
+			size *= 2;
+			pool = new wchar_t[size];
+			pool[0] = L'\0';
+		}
+	}
+
+	if (pool != wpool) {
+		delete[] pool;
+	}
+
+	return message;
+}
+
+/*************************************************************************************************/
+ISyslogReceiver::ISyslogReceiver(Log level, Platform::String^ topic) : level(level), topic(topic) {
+	this->latency = new SyslogHistogram();
+}
+
+ISyslogReceiver::~ISyslogReceiver() {
+	delete this->latency;
+}
+
 void ISyslogReceiver::log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
 	if (level >= this->level) {
 		if ((this->topic == nullptr) || (this->topic->Equals(topic))) {
-			this->on_log_message(level, message, data, topic);
+			this->dispatch_log_message(level, message, data, topic);
 		}
 	}
 }
 
+void ISyslogReceiver::snapshot_latency(SyslogHistogramSnapshot* snapshot) {
+	this->latency->snapshot(snapshot);
+}
+
+void ISyslogReceiver::dispatch_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	unsigned long long start = current_tsc_ticks();
+
+	this->on_log_message(level, message, data, topic);
+	this->latency->record(current_tsc_ticks() - start);
+}
+
 /*************************************************************************************************/
-Syslog::Syslog(Log level, Platform::String^ topic, Syslog* parent) : level(level), topic(topic) {
-	if (parent != nullptr) {
-		this->parent = parent;
-		this->parent->reference();
-	}
+Syslog::Syslog(Log level, Platform::String^ topic, Syslog* parent) : level(level), topic(topic), parent(parent) {
+	this->metrics = new SyslogMetrics();
 }
 
 Syslog::~Syslog() {
-	while (!this->receivers.empty()) {
-		this->receivers.front()->destroy();
-		this->receivers.pop_front();
+	if (this->limiter != nullptr) {
+		this->flush();
+		delete this->limiter;
 	}
 
-	if (parent != nullptr) {
-		this->parent->destroy();
+	if (this->queue != nullptr) {
+		// the pending messages are dispatched before the consumer exits
+		delete this->queue;
 	}
+
+	delete this->metrics;
+
+	// receivers and the parent are released after the queue has been drained
 }
 
 Platform::String^ Syslog::get_name() {
@@ -38,34 +123,122 @@ Platform::String^ Syslog::get_name() {
 
 void Syslog::push_log_receiver(ISyslogReceiver* receiver) {
 	if (receiver != nullptr) {
-		receiver->reference();
+		std::unique_lock<std::mutex> guard(routing_section);
+
 		this->receivers.push_back(receiver);
+		routing_generation++;
+	}
+}
+
+void Syslog::enable_async(size_t capacity, SyslogOverflow policy, bool deferred_formatting) {
+	if (this->queue == nullptr) {
+		this->queue = new SyslogQueue([this](SyslogRecord& record) {
+			if (record.message == nullptr) {
+				Platform::String^ message = syslog_render_arguments(&record.args);
+
+				record.meta.args = &record.args;
+				record.message = ((record.topic == nullptr) ? message : (record.topic + ": " + message));
+			}
+
+			this->dispatch_log_message(record.level, record.message, record.meta, record.topic);
+		}, capacity, policy);
+
+		this->deferred = deferred_formatting;
+	}
+}
+
+bool Syslog::async_statistics(SyslogQueueStatistics* stat) {
+	bool async = (this->queue != nullptr);
+
+	if (async) {
+		this->queue->statistics(stat);
+	}
+
+	return async;
+}
+
+void Syslog::flush() {
+	if (this->limiter != nullptr) {
+		this->limiter->drain([this](Platform::String^ topic, SyslogLimiterNote& note) {
+			this->report_suppressed(topic, note.level, note.repeated, note.limited);
+		});
+	}
+
+	if (this->queue != nullptr) {
+		this->queue->flush();
+	}
+}
+
+void Syslog::limit_rate(double messages_per_second, double burst, bool collapse_duplicates) {
+	if (this->limiter == nullptr) {
+		this->limiter = new SyslogLimiter(messages_per_second, burst, collapse_duplicates);
+	}
+}
+
+bool Syslog::limiter_statistics(SyslogLimiterStatistics* stat) {
+	bool limited = (this->limiter != nullptr);
+
+	if (limited) {
+		this->limiter->statistics(stat);
+	}
+
+	return limited;
+}
+
+void Syslog::snapshot_metrics(SyslogMetricsSnapshot* snapshot) {
+	SyslogQueueStatistics queue_stat;
+	SyslogLimiterStatistics limiter_stat;
+
+	this->metrics->snapshot(snapshot);
+
+	if (this->async_statistics(&queue_stat)) {
+		snapshot->dropped = queue_stat.dropped;
+	}
+
+	if (this->limiter_statistics(&limiter_stat)) {
+		snapshot->suppressed = limiter_stat.limited + limiter_stat.collapsed;
 	}
 }
 
 void Syslog::log_message(WarGrey::SCADA::Log level, Platform::String^ message) {
-	if (level >= this->level) {
-		this->do_log_message(level, message, this->topic, true);
+	if (this->accepts(level)) {
+		this->metrics->record(level, this->topic);
+
+		if ((this->limiter == nullptr) || this->admits(level, this->topic, syslog_message_hash(message))) {
+			this->do_log_message(level, message, this->topic, true);
+		}
 	}
 }
 
 void Syslog::log_message(Platform::String^ alt_topic, WarGrey::SCADA::Log level, Platform::String^ message) {
-	if (level >= this->level) {
-		this->do_log_message(level, message, alt_topic, true);
+	if (this->accepts(level)) {
+		this->metrics->record(level, ((alt_topic == nullptr) ? this->topic : alt_topic));
+
+		if ((this->limiter == nullptr) || this->admits(level, alt_topic, syslog_message_hash(message))) {
+			this->do_log_message(level, message, alt_topic, true);
+		}
 	}
 }
 
 void Syslog::log_message(WarGrey::SCADA::Log level, const wchar_t* msgfmt, ...) {
-	if (level >= this->level) {
-		VSWPRINT(message, msgfmt);
-		this->do_log_message(level, message, this->topic, true);
+	if (this->accepts(level)) {
+		va_list argl;
+
+		this->metrics->record(level, this->topic);
+		va_start(argl, msgfmt);
+		this->do_log_message(level, msgfmt, argl, this->topic);
+		va_end(argl);
 	}
 }
 
 void Syslog::log_message(Platform::String^ alt_topic, WarGrey::SCADA::Log level, const wchar_t* msgfmt, ...) {
-	if (level >= this->level) {
-		VSWPRINT(message, msgfmt);
-		this->do_log_message(level, message, alt_topic, true);
+	if (this->accepts(level)) {
+		va_list argl;
+
+		this->metrics->record(level, ((alt_topic == nullptr) ? this->topic : alt_topic));
+		va_start(argl, msgfmt);
+		this->do_log_message(level, msgfmt, argl, alt_topic);
+		va_end(argl);
 	}
 }
 
@@ -73,16 +246,177 @@ void Syslog::do_log_message(WarGrey::SCADA::Log level, Platform::String^ message
 	SyslogMetainfo attachment;
 	auto actual_topic = ((topic == nullptr) ? this->topic : topic);
 	auto actual_message = (((!prefix) || (actual_topic == nullptr)) ? message : (actual_topic + ": " + message));
-	Syslog* logger = this;
 
 	attachment.timestamp = update_nowstamp();
+	attachment.timepoint = current_100nanoseconds();
+
+	if (this->queue == nullptr) {
+		this->dispatch_log_message(level, actual_message, attachment, actual_topic);
+	} else {
+		SyslogRecord record;
+
+		record.level = level;
+		record.message = actual_message;
+		record.topic = actual_topic;
+		record.meta = attachment;
+
+		this->queue->push(record);
 
-	while (logger != nullptr) {
-		for (auto r : logger->receivers) {
-			r->log_message(level, actual_message, attachment, actual_topic);
+		if (level == Log::Panic) {
+			// receivers should have everything before the process goes down
+			this->queue->flush();
 		}
+	}
+}
+
+void Syslog::do_log_message(Log level, const wchar_t* msgfmt, va_list argl, Platform::String^ topic) {
+	SyslogRecord record;
+	bool captured = false;
+
+	if (this->deferred || (this->limiter != nullptr)) {
+		va_list args;
 
-		// TODO: do we need propagated level?
-		logger = logger->parent;
+		va_copy(args, argl);
+		captured = syslog_capture_arguments(&record.args, msgfmt, args);
+		va_end(args);
 	}
+
+	if ((!captured) || (this->limiter == nullptr) || this->admits(level, topic, syslog_message_hash(&record.args))) {
+		if (captured && this->deferred) {
+			record.level = level;
+			record.message = nullptr;
+			record.topic = ((topic == nullptr) ? this->topic : topic);
+			record.meta.timestamp = update_nowstamp();
+			record.meta.timepoint = current_100nanoseconds();
+
+			this->queue->push(record);
+
+			if (level == Log::Panic) {
+				this->queue->flush();
+			}
+		} else {
+			Platform::String^ message = vformat_message(msgfmt, argl);
+
+			if (captured || (this->limiter == nullptr) || this->admits(level, topic, syslog_message_hash(message))) {
+				this->do_log_message(level, message, topic, true);
+			}
+		}
+	}
+}
+
+void Syslog::dispatch_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	std::shared_ptr<const SyslogRoutes> routes = this->routing_table();
+	const std::vector<SyslogRoute>* targets = &routes->untopic;
+
+	if ((topic == this->topic) || ((topic != nullptr) && topic->Equals(this->topic))) {
+		targets = &routes->own;
+	} else if (topic != nullptr) {
+		auto it = routes->topics.find(std::wstring(topic->Data(), topic->Length()));
+
+		if (it != routes->topics.end()) {
+			targets = &it->second;
+		}
+	}
+
+	for (auto it = targets->begin(); it != targets->end(); it++) {
+		if (level >= it->level) {
+			it->receiver->dispatch_log_message(level, message, data, topic);
+		}
+	}
+}
+
+/*************************************************************************************************/
+void Syslog::set_level(Log level) {
+	this->level.store(level, std::memory_order_relaxed);
+}
+
+Log Syslog::get_level() {
+	return this->level.load(std::memory_order_relaxed);
+}
+
+bool Syslog::accepts(Log level) {
+	if (this->floor_generation.load(std::memory_order_acquire) != routing_generation.load(std::memory_order_acquire)) {
+		this->routing_table(); // which also refreshes the floor
+	}
+
+	return ((level >= this->level.load(std::memory_order_relaxed)) && (level >= this->floor.load(std::memory_order_relaxed)));
+}
+
+bool Syslog::admits(Log level, Platform::String^ topic, unsigned long long hash) {
+	bool admitted = true;
+
+	if (this->limiter != nullptr) {
+		Platform::String^ actual_topic = ((topic == nullptr) ? this->topic : topic);
+		SyslogLimiterNote note;
+
+		admitted = this->limiter->admit(actual_topic, level, hash, current_coarse_monotonic_milliseconds(), &note);
+		this->report_suppressed(actual_topic, note.level, note.repeated, note.limited);
+	}
+
+	return admitted;
+}
+
+void Syslog::report_suppressed(Platform::String^ topic, Log level, unsigned long long repeated, unsigned long long limited) {
+	if (repeated > 0ULL) {
+		this->do_log_message(level, make_wstring(L"last message repeated %llu times", repeated), topic, true);
+	}
+
+	if (limited > 0ULL) {
+		this->do_log_message(Log::Warning, make_wstring(L"%llu messages suppressed by rate limiting", limited), topic, true);
+	}
+}
+
+std::shared_ptr<const SyslogRoutes> Syslog::routing_table() {
+	std::shared_ptr<const SyslogRoutes> routes = std::atomic_load(&this->routes);
+
+	if ((routes == nullptr) || (routes->generation != routing_generation.load(std::memory_order_acquire))) {
+		std::unique_lock<std::mutex> guard(routing_section);
+		std::shared_ptr<SyslogRoutes> table = std::make_shared<SyslogRoutes>();
+		std::vector<ISyslogReceiver*> chain;
+
+		table->generation = routing_generation.load();
+		table->floor = Log::_;
+
+		for (Syslog* logger = this; logger != nullptr; logger = logger->parent.get()) {
+			for (auto& r : logger->receivers) {
+				chain.push_back(r.get());
+
+				if (r->level < table->floor) {
+					table->floor = r->level;
+				}
+			}
+		}
+
+		for (auto r : chain) {
+			if (r->topic == nullptr) {
+				table->untopic.push_back({ r, r->level });
+			} else {
+				table->topics[std::wstring(r->topic->Data(), r->topic->Length())];
+			}
+		}
+
+		// keep the order in which receivers are walked along the parent chain
+		for (auto t = table->topics.begin(); t != table->topics.end(); t++) {
+			for (auto r : chain) {
+				if ((r->topic == nullptr) || (t->first.compare(r->topic->Data()) == 0)) {
+					t->second.push_back({ r, r->level });
+				}
+			}
+		}
+
+		if (this->topic != nullptr) {
+			auto own = table->topics.find(std::wstring(this->topic->Data(), this->topic->Length()));
+
+			table->own = ((own == table->topics.end()) ? table->untopic : own->second);
+		} else {
+			table->own = table->untopic;
+		}
+
+		routes = table;
+		std::atomic_store(&this->routes, routes);
+		this->floor.store(table->floor, std::memory_order_relaxed);
+		this->floor_generation.store(table->generation, std::memory_order_release);
+	}
+
+	return routes;
 }
@@ -1,25 +1,102 @@
 #pragma once
 
 #include <deque>
+#include <memory>
+#include <atomic>
+#include <cstdarg>
 
 #include "datum/object.hpp"
 
+/** NOTE
+ * Calls below `SYSLOG_COMPILED_LEVEL` are removed by the preprocessor along with their arguments,
+ *   define it (as the index of `Log`: 0 for Debug, 1 for Info, ...) in the project settings, say, 2 for release builds.
+ *
+ * The rest evaluate their arguments only if the logger accepts the level at runtime.
+ */
+#ifndef SYSLOG_COMPILED_LEVEL
+#define SYSLOG_COMPILED_LEVEL 0
+#endif
+
+#define SYSLOG_LOG(logger, level, ...) \
+	do { \
+		WarGrey::SCADA::Syslog* syslog_logger = (logger); \
+		if (syslog_logger->accepts(level)) { syslog_logger->log_message(level, __VA_ARGS__); } \
+	} while (0)
+
+#define SYSLOG_TOPIC_LOG(logger, topic, level, ...) \
+	do { \
+		WarGrey::SCADA::Syslog* syslog_logger = (logger); \
+		if (syslog_logger->accepts(level)) { syslog_logger->log_message(topic, level, __VA_ARGS__); } \
+	} while (0)
+
+#if SYSLOG_COMPILED_LEVEL <= 0
+#define SYSLOG_DEBUG(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Debug, __VA_ARGS__)
+#else
+#define SYSLOG_DEBUG(logger, ...) ((void)0)
+#endif
+
+#if SYSLOG_COMPILED_LEVEL <= 1
+#define SYSLOG_INFO(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Info, __VA_ARGS__)
+#else
+#define SYSLOG_INFO(logger, ...) ((void)0)
+#endif
+
+#if SYSLOG_COMPILED_LEVEL <= 2
+#define SYSLOG_NOTICE(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Notice, __VA_ARGS__)
+#else
+#define SYSLOG_NOTICE(logger, ...) ((void)0)
+#endif
+
+#if SYSLOG_COMPILED_LEVEL <= 3
+#define SYSLOG_WARNING(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Warning, __VA_ARGS__)
+#else
+#define SYSLOG_WARNING(logger, ...) ((void)0)
+#endif
+
+// errors and above are never compiled out
+#define SYSLOG_ERROR(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Error, __VA_ARGS__)
+#define SYSLOG_CRITICAL(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Critical, __VA_ARGS__)
+#define SYSLOG_ALARM(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Alarm, __VA_ARGS__)
+#define SYSLOG_PANIC(logger, ...) SYSLOG_LOG(logger, WarGrey::SCADA::Log::Panic, __VA_ARGS__)
+
 namespace WarGrey::SCADA {
 	private enum class Log { Debug, Info, Notice, Warning, Error, Critical, Alarm, Panic, _ };
+	private enum class SyslogOverflow { Block, DropNewest, DropOldest };
+
+	class SyslogQueue;
+	struct SyslogQueueStatistics;
+	struct SyslogArguments;
+	struct SyslogRoutes;
+	struct SyslogLimiterStatistics;
+	class SyslogLimiter;
+	struct SyslogMetricsSnapshot;
+	struct SyslogHistogramSnapshot;
+	class SyslogMetrics;
+	class SyslogHistogram;
+	class Syslog;
+	class IsolatedReceiver;
 
 	private struct SyslogMetainfo {
 		Platform::String^ timestamp;
+		long long timepoint = 0LL; // 100ns
+		const WarGrey::SCADA::SyslogArguments* args = nullptr; // captured in the deferred mode
 	};
 
 	private class ISyslogReceiver abstract : public WarGrey::SCADA::SharedObject {
+		friend class WarGrey::SCADA::Syslog;
+		friend class WarGrey::SCADA::IsolatedReceiver;
+
 	public:
-		ISyslogReceiver(WarGrey::SCADA::Log level, Platform::String^ topic = "")
-			: level(level), topic(topic) {};
+		ISyslogReceiver(WarGrey::SCADA::Log level, Platform::String^ topic = "");
 
 	public:
 		void log_message(WarGrey::SCADA::Log level, Platform::String^ message,
 			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic);
 
+	public:
+		// the time spent in `on_log_message`
+		void snapshot_latency(WarGrey::SCADA::SyslogHistogramSnapshot* snapshot);
+
 	protected:
 		virtual void on_log_message(
 			WarGrey::SCADA::Log level,
@@ -28,11 +105,16 @@ namespace WarGrey::SCADA {
 			Platform::String^ topic) = 0;
 
 	protected:
-		~ISyslogReceiver() noexcept {}
+		~ISyslogReceiver() noexcept;
+
+	private:
+		void dispatch_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic);
 
 	private:
 		WarGrey::SCADA::Log level;
 		Platform::String^ topic;
+		WarGrey::SCADA::SyslogHistogram* latency;
 	};
 
 	private class Syslog final : public WarGrey::SCADA::SharedObject {
@@ -51,18 +133,77 @@ namespace WarGrey::SCADA {
 		void log_message(Platform::String^ alt_topic, WarGrey::SCADA::Log level, Platform::String^ message);
 		void log_message(Platform::String^ alt_topic, WarGrey::SCADA::Log level, const wchar_t* msgfmt, ...);
 
+	public:
+		/** NOTE
+		 * The level can be changed at any time from any thread,
+		 *   `accepts` tells whether a message of `level` would reach any receiver, use it (or the `SYSLOG_*` macros)
+		 *   to avoid building messages that would be discarded.
+		 */
+		void set_level(WarGrey::SCADA::Log level);
+		WarGrey::SCADA::Log get_level();
+		bool accepts(WarGrey::SCADA::Log level);
+
+	public:
+		/** NOTE
+		 * In asynchronous mode, messages are formatted and timestamped on the caller's thread,
+		 *   and then dispatched to receivers (including the ones of parents) on a dedicated thread.
+		 *
+		 * Enable it before the logger is shared among threads, it stays on until the logger is destroyed.
+		 *
+		 * With `deferred_formatting`, the printf-style `log_message`s only capture the format and the raw arguments,
+		 *   and the formatting happens on the dispatching thread, so the formats must be string literals.
+		 */
+		void enable_async(size_t capacity = 4096U, WarGrey::SCADA::SyslogOverflow policy = WarGrey::SCADA::SyslogOverflow::DropOldest,
+			bool deferred_formatting = false);
+		bool async_statistics(WarGrey::SCADA::SyslogQueueStatistics* stat);
+		void flush();
+
+	public:
+		/** NOTE
+		 * Messages of each topic are limited to `messages_per_second` with bursts of `burst` messages,
+		 *   and consecutive duplicates are collapsed into "last message repeated N times" if `collapse_duplicates`.
+		 *
+		 * Printf-style messages are compared by the format and the raw arguments before being formatted,
+		 *   non-positive `messages_per_second` disables the rate limiting.
+		 */
+		void limit_rate(double messages_per_second, double burst = 0.0, bool collapse_duplicates = true);
+		bool limiter_statistics(WarGrey::SCADA::SyslogLimiterStatistics* stat);
+
+	public:
+		// counters of this logger only, the ones of parents are not included
+		void snapshot_metrics(WarGrey::SCADA::SyslogMetricsSnapshot* snapshot);
+
 	protected:
 		~Syslog() noexcept;
 
+	private:
+		/** NOTE
+		 * Receivers of the logger and its parents are flattened into a routing table per topic,
+		 *   the table is rebuilt lazily once any logger in the process gets a new receiver.
+		 */
+		std::shared_ptr<const WarGrey::SCADA::SyslogRoutes> routing_table();
+		bool admits(WarGrey::SCADA::Log level, Platform::String^ topic, unsigned long long hash);
+		void report_suppressed(Platform::String^ topic, WarGrey::SCADA::Log level, unsigned long long repeated, unsigned long long limited);
+
 	private:
 		void do_log_message(WarGrey::SCADA::Log level, Platform::String^ message, Platform::String^ alt_topic, bool prefix);
+		void do_log_message(WarGrey::SCADA::Log level, const wchar_t* msgfmt, va_list argl, Platform::String^ alt_topic);
+		void dispatch_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic);
 
 	private:
-		WarGrey::SCADA::Log level;
+		std::atomic<WarGrey::SCADA::Log> level;
 		Platform::String^ topic;
-		Syslog* parent;
+		WarGrey::SCADA::SharedReference<WarGrey::SCADA::Syslog> parent;
+		WarGrey::SCADA::SyslogQueue* queue = nullptr;
+		WarGrey::SCADA::SyslogLimiter* limiter = nullptr;
+		WarGrey::SCADA::SyslogMetrics* metrics = nullptr;
+		bool deferred = false;
 
 	private:
-		std::deque<WarGrey::SCADA::ISyslogReceiver*> receivers;
+		std::deque<WarGrey::SCADA::SharedReference<WarGrey::SCADA::ISyslogReceiver>> receivers;
+		std::shared_ptr<const WarGrey::SCADA::SyslogRoutes> routes;
+		std::atomic<WarGrey::SCADA::Log> floor { WarGrey::SCADA::Log::_ }; // cached for `accepts()`
+		std::atomic<unsigned long long> floor_generation { 0ULL };
 	};
 }
@@ -0,0 +1,207 @@
+#include <cwchar>
+
+#include "syslog/metrics.hpp"
+
+#include "datum/time.hpp"
+#include "datum/hash.hpp"
+
+using namespace WarGrey::SCADA;
+
+static size_t shard_index() {
+	static std::atomic<size_t> next_index(0U);
+	thread_local size_t index = next_index.fetch_add(1U, std::memory_order_relaxed) % syslog_metrics_shard_count;
+
+	return index;
+}
+
+static size_t bucket_index(unsigned long long ticks) {
+	size_t idx = 0U;
+
+	while ((ticks > 0ULL) && (idx < syslog_histogram_bucket_count - 1U)) {
+		ticks >>= 1U;
+		idx++;
+	}
+
+	return idx;
+}
+
+/*************************************************************************************************/
+double WarGrey::SCADA::syslog_histogram_bucket_upper_ms(size_t idx) {
+	return tsc_ticks_to_inexact_milliseconds(1ULL << idx);
+}
+
+double WarGrey::SCADA::syslog_histogram_percentile_ms(const SyslogHistogramSnapshot* snapshot, double percentile) {
+	double upper = 0.0;
+
+	if (snapshot->count > 0ULL) {
+		unsigned long long rank = (unsigned long long)(double(snapshot->count) * percentile / 100.0);
+		unsigned long long seen = 0ULL;
+
+		for (size_t idx = 0U; idx < syslog_histogram_bucket_count; idx++) {
+			seen += snapshot->buckets[idx];
+
+			if (seen > rank) {
+				upper = syslog_histogram_bucket_upper_ms(idx);
+				break;
+			}
+		}
+
+		if (upper > snapshot->max_ms) {
+			upper = snapshot->max_ms;
+		}
+	}
+
+	return upper;
+}
+
+/*************************************************************************************************/
+SyslogHistogram::SyslogHistogram() {
+	for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+		for (size_t idx = 0U; idx < syslog_histogram_bucket_count; idx++) {
+			this->shards[sdx].buckets[idx].store(0ULL, std::memory_order_relaxed);
+		}
+
+		this->shards[sdx].total.store(0ULL, std::memory_order_relaxed);
+		this->shards[sdx].max.store(0ULL, std::memory_order_relaxed);
+	}
+}
+
+void SyslogHistogram::record(unsigned long long ticks) {
+	SyslogHistogram::Shard* self = &this->shards[shard_index()];
+	unsigned long long max = self->max.load(std::memory_order_relaxed);
+
+	self->buckets[bucket_index(ticks)].fetch_add(1ULL, std::memory_order_relaxed);
+	self->total.fetch_add(ticks, std::memory_order_relaxed);
+
+	while ((ticks > max) && (!self->max.compare_exchange_weak(max, ticks, std::memory_order_relaxed)));
+}
+
+void SyslogHistogram::snapshot(SyslogHistogramSnapshot* snapshot) {
+	unsigned long long total = 0ULL;
+	unsigned long long max = 0ULL;
+
+	snapshot->count = 0ULL;
+
+	for (size_t idx = 0U; idx < syslog_histogram_bucket_count; idx++) {
+		snapshot->buckets[idx] = 0ULL;
+
+		for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+			snapshot->buckets[idx] += this->shards[sdx].buckets[idx].load(std::memory_order_relaxed);
+		}
+
+		snapshot->count += snapshot->buckets[idx];
+	}
+
+	for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+		unsigned long long smax = this->shards[sdx].max.load(std::memory_order_relaxed);
+
+		total += this->shards[sdx].total.load(std::memory_order_relaxed);
+
+		if (smax > max) {
+			max = smax;
+		}
+	}
+
+	snapshot->total_ms = tsc_ticks_to_inexact_milliseconds(total);
+	snapshot->max_ms = tsc_ticks_to_inexact_milliseconds(max);
+}
+
+/*************************************************************************************************/
+SyslogMetrics::SyslogMetrics() {
+	for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+		for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+			this->shards[sdx].levels[idx].store(0ULL, std::memory_order_relaxed);
+		}
+
+		for (size_t idx = 0U; idx < syslog_metrics_topic_slot_count; idx++) {
+			this->shards[sdx].topics[idx].hash.store(0ULL, std::memory_order_relaxed);
+			this->shards[sdx].topics[idx].name.store(nullptr, std::memory_order_relaxed);
+			this->shards[sdx].topics[idx].count.store(0ULL, std::memory_order_relaxed);
+		}
+
+		this->shards[sdx].untracked.store(0ULL, std::memory_order_relaxed);
+	}
+}
+
+SyslogMetrics::~SyslogMetrics() {
+	for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+		for (size_t idx = 0U; idx < syslog_metrics_topic_slot_count; idx++) {
+			const wchar_t* name = this->shards[sdx].topics[idx].name.load(std::memory_order_relaxed);
+
+			if (name != nullptr) {
+				delete[] name;
+			}
+		}
+	}
+}
+
+void SyslogMetrics::record(Log level, Platform::String^ topic) {
+	SyslogMetrics::Shard* self = &this->shards[shard_index()];
+	const wchar_t* name = ((topic == nullptr) ? L"" : topic->Data());
+	size_t size = ((topic == nullptr) ? 0U : topic->Length());
+	unsigned long long hash = fnv1a_hash(name, size * sizeof(wchar_t));
+	bool tracked = false;
+
+	self->levels[_I(level)].fetch_add(1ULL, std::memory_order_relaxed);
+
+	if (hash == 0ULL) { // reserved for free slots
+		hash = fnv1a_prime;
+	}
+
+	for (size_t probe = 0U; probe < syslog_metrics_topic_slot_count; probe++) {
+		SyslogMetrics::TopicSlot* slot = &self->topics[(size_t(hash) + probe) % syslog_metrics_topic_slot_count];
+		unsigned long long key = slot->hash.load(std::memory_order_acquire);
+
+		if (key == 0ULL) {
+			if (slot->hash.compare_exchange_strong(key, hash, std::memory_order_acq_rel)) {
+				wchar_t* copy = new wchar_t[size + 1U];
+
+				std::wmemcpy(copy, name, size);
+				copy[size] = L'\0';
+				slot->name.store(copy, std::memory_order_release);
+				key = hash;
+			}
+		}
+
+		if (key == hash) {
+			slot->count.fetch_add(1ULL, std::memory_order_relaxed);
+			tracked = true;
+			break;
+		}
+	}
+
+	if (!tracked) {
+		self->untracked.fetch_add(1ULL, std::memory_order_relaxed);
+	}
+}
+
+void SyslogMetrics::snapshot(SyslogMetricsSnapshot* snapshot) {
+	for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+		snapshot->levels[idx] = 0ULL;
+	}
+
+	snapshot->topics.clear();
+	snapshot->untracked = 0ULL;
+
+	for (size_t sdx = 0U; sdx < syslog_metrics_shard_count; sdx++) {
+		SyslogMetrics::Shard* self = &this->shards[sdx];
+
+		for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+			snapshot->levels[idx] += self->levels[idx].load(std::memory_order_relaxed);
+		}
+
+		for (size_t idx = 0U; idx < syslog_metrics_topic_slot_count; idx++) {
+			// the name is not published yet, its counts will show up next time
+			const wchar_t* name = self->topics[idx].name.load(std::memory_order_acquire);
+
+			if (name != nullptr) {
+				snapshot->topics[name] += self->topics[idx].count.load(std::memory_order_relaxed);
+			}
+		}
+
+		snapshot->untracked += self->untracked.load(std::memory_order_relaxed);
+	}
+
+	snapshot->dropped = 0ULL;
+	snapshot->suppressed = 0ULL;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <atomic>
+#include <string>
+
+#include "syslog/logging.hpp"
+
+#include "datum/enum.hpp"
+
+namespace WarGrey::SCADA {
+	static const size_t syslog_metrics_shard_count = 16U;
+	static const size_t syslog_histogram_bucket_count = 40U;
+	static const size_t syslog_metrics_topic_slot_count = 64U; // per shard
+
+	private struct SyslogHistogramSnapshot {
+		unsigned long long count;
+		double total_ms;
+		double max_ms;
+		unsigned long long buckets[syslog_histogram_bucket_count]; // see `syslog_histogram_bucket_upper_ms`
+	};
+
+	private struct SyslogMetricsSnapshot {
+		unsigned long long levels[_N(WarGrey::SCADA::Log)]; // messages that pass the level of the logger
+		std::map<std::wstring, unsigned long long> topics;  // ditto, `L""` for messages without topic
+		unsigned long long untracked;                       // ditto, but their topics do not fit in the tables
+		unsigned long long dropped;                         // by the asynchronous queue
+		unsigned long long suppressed;                      // by the rate limiter, duplicates included
+	};
+
+	/** NOTE
+	 * The bucket `i` counts latencies in [2^(i-1), 2^i) TSC ticks, the last bucket also takes everything beyond.
+	 *
+	 * Percentiles are the upper bounds of the buckets, so they are accurate to a factor of 2.
+	 */
+	double syslog_histogram_bucket_upper_ms(size_t idx);
+	double syslog_histogram_percentile_ms(const WarGrey::SCADA::SyslogHistogramSnapshot* snapshot, double percentile);
+
+	/** NOTE
+	 * Both the counters and the histograms are sharded by threads,
+	 *   every thread only touches its own shard (or shares it with a few others once there are more threads than shards),
+	 *   and snapshots sum up all shards without stopping writers.
+	 *
+	 * Topics are counted in fixed open-addressed tables keyed by the FNV-1a hash of their names,
+	 *   a slot is claimed once and never released, so recording is lock-free and never allocates but for the first time.
+	 */
+	private class SyslogHistogram {
+	public:
+		SyslogHistogram();
+
+	public:
+		void record(unsigned long long ticks);
+		void snapshot(WarGrey::SCADA::SyslogHistogramSnapshot* snapshot);
+
+	private:
+		struct alignas(64) Shard {
+			std::atomic<unsigned long long> buckets[syslog_histogram_bucket_count];
+			std::atomic<unsigned long long> total;
+			std::atomic<unsigned long long> max;
+		};
+
+	private:
+		WarGrey::SCADA::SyslogHistogram::Shard shards[syslog_metrics_shard_count];
+	};
+
+	private class SyslogMetrics {
+	public:
+		~SyslogMetrics() noexcept;
+		SyslogMetrics();
+
+	public:
+		void record(WarGrey::SCADA::Log level, Platform::String^ topic);
+		void snapshot(WarGrey::SCADA::SyslogMetricsSnapshot* snapshot);
+
+	private:
+		struct TopicSlot {
+			std::atomic<unsigned long long> hash; // `0ULL` for free slots
+			std::atomic<const wchar_t*> name;     // published after the slot is claimed
+			std::atomic<unsigned long long> count;
+		};
+
+		struct alignas(64) Shard {
+			std::atomic<unsigned long long> levels[_N(WarGrey::SCADA::Log)];
+			WarGrey::SCADA::SyslogMetrics::TopicSlot topics[syslog_metrics_topic_slot_count];
+			std::atomic<unsigned long long> untracked;
+		};
+
+	private:
+		WarGrey::SCADA::SyslogMetrics::Shard shards[syslog_metrics_shard_count];
+	};
+}
@@ -0,0 +1,227 @@
+#include <chrono>
+
+#include "syslog/queue.hpp"
+
+using namespace WarGrey::SCADA;
+
+static size_t ring_capacity(size_t capacity) {
+	size_t size = 2U;
+
+	while (size < capacity) {
+		size <<= 1U;
+	}
+
+	return size;
+}
+
+/*************************************************************************************************/
+SyslogQueue::SyslogQueue(std::function<void(SyslogRecord&)> dispatch, size_t capacity, SyslogOverflow policy)
+	: cells(ring_capacity(capacity)), dispatch(dispatch), policy(policy) {
+	this->mask = this->cells.size() - 1U;
+
+	for (size_t idx = 0; idx < this->cells.size(); idx++) {
+		this->cells[idx].sequence.store(idx, std::memory_order_relaxed);
+	}
+
+	this->enqueue_pos.store(0U);
+	this->dequeue_pos.store(0U);
+	this->sleeping.store(false);
+	this->blocking.store(0U);
+	this->max_depth.store(0U);
+	this->pushed.store(0ULL);
+	this->dispatched.store(0ULL);
+	this->dropped.store(0ULL);
+
+	this->consumer = std::thread([this]() { this->consume(); });
+}
+
+SyslogQueue::~SyslogQueue() {
+	this->shutdown();
+}
+
+bool SyslogQueue::push(SyslogRecord& record) {
+	bool okay = this->try_push(record);
+
+	if (!okay) {
+		switch (this->policy) {
+		case SyslogOverflow::Block: {
+			std::unique_lock<std::mutex> guard(this->section);
+
+			this->blocking++;
+			while (!this->stopping) {
+				okay = this->try_push(record);
+
+				if (okay) {
+					break;
+				}
+
+				this->space.wait_for(guard, std::chrono::milliseconds(10));
+			}
+			this->blocking--;
+		}; break;
+		case SyslogOverflow::DropOldest: {
+			SyslogRecord victim;
+
+			do {
+				if (this->try_pop(&victim)) {
+					this->dropped++;
+				}
+
+				okay = this->try_push(record);
+			} while (!okay);
+		}; break;
+		default: /* SyslogOverflow::DropNewest */; break;
+		}
+	}
+
+	if (okay) {
+		size_t depth = this->depth();
+		size_t peak = this->max_depth.load(std::memory_order_relaxed);
+
+		while ((depth > peak) && (!this->max_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)));
+		this->pushed++;
+
+		if (this->sleeping.load()) {
+			this->section.lock();
+			this->section.unlock();
+			this->ready.notify_one();
+		}
+	} else {
+		this->dropped++;
+	}
+
+	return okay;
+}
+
+void SyslogQueue::flush() {
+	if (std::this_thread::get_id() != this->consumer.get_id()) {
+		std::unique_lock<std::mutex> guard(this->section);
+
+		this->drained.wait(guard, [this]() {
+			return this->stopping || (this->sleeping.load() && (this->depth() == 0U));
+		});
+	}
+}
+
+void SyslogQueue::shutdown() {
+	if (this->consumer.joinable()) {
+		this->section.lock();
+		this->stopping = true;
+		this->section.unlock();
+
+		this->ready.notify_all();
+		this->space.notify_all();
+		this->consumer.join();
+		this->drained.notify_all();
+	}
+}
+
+size_t SyslogQueue::depth() {
+	size_t tail = this->dequeue_pos.load(std::memory_order_relaxed);
+	size_t head = this->enqueue_pos.load(std::memory_order_relaxed);
+	size_t depth = ((head > tail) ? (head - tail) : 0U);
+
+	// both positions are moving while being loaded
+	return ((depth < this->cells.size()) ? depth : this->cells.size());
+}
+
+void SyslogQueue::statistics(SyslogQueueStatistics* stat) {
+	stat->capacity = this->cells.size();
+	stat->depth = this->depth();
+	stat->max_depth = this->max_depth.load();
+	stat->pushed = this->pushed.load();
+	stat->dispatched = this->dispatched.load();
+	stat->dropped = this->dropped.load();
+}
+
+/*************************************************************************************************/
+bool SyslogQueue::try_push(SyslogRecord& record) {
+	size_t pos = this->enqueue_pos.load(std::memory_order_relaxed);
+
+	while (true) {
+		SyslogQueue::Cell* cell = &this->cells[pos & this->mask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		long long diff = (long long)(seq) - (long long)(pos);
+
+		if (diff == 0LL) {
+			if (this->enqueue_pos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+				cell->record = record;
+				cell->sequence.store(pos + 1U, std::memory_order_release);
+
+				return true;
+			}
+		} else if (diff < 0LL) { // full
+			return false;
+		} else {
+			pos = this->enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool SyslogQueue::try_pop(SyslogRecord* record) {
+	size_t pos = this->dequeue_pos.load(std::memory_order_relaxed);
+
+	while (true) {
+		SyslogQueue::Cell* cell = &this->cells[pos & this->mask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		long long diff = (long long)(seq) - (long long)(pos + 1U);
+
+		if (diff == 0LL) {
+			if (this->dequeue_pos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+				(*record) = cell->record;
+				this->release(&cell->record);
+				cell->sequence.store(pos + this->mask + 1U, std::memory_order_release);
+
+				return true;
+			}
+		} else if (diff < 0LL) { // empty, or the producer has not finished writing the cell
+			return false;
+		} else {
+			pos = this->dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void SyslogQueue::release(SyslogRecord* record) {
+	// release the strings as soon as possible, the arguments pool is left as is
+	record->message = nullptr;
+	record->topic = nullptr;
+	record->meta = SyslogMetainfo();
+}
+
+void SyslogQueue::consume() {
+	SyslogRecord record;
+
+	while (true) {
+		if (this->try_pop(&record)) {
+			this->dispatch(record);
+			this->dispatched++;
+			this->release(&record);
+
+			if (this->blocking.load() > 0U) {
+				this->section.lock();
+				this->section.unlock();
+				this->space.notify_all();
+			}
+		} else {
+			std::unique_lock<std::mutex> guard(this->section);
+
+			if (this->depth() == 0U) {
+				if (this->stopping) {
+					break;
+				}
+
+				this->sleeping.store(true);
+				this->drained.notify_all();
+				this->ready.wait_for(guard, std::chrono::milliseconds(100), [this]() {
+					return this->stopping || (this->depth() > 0U);
+				});
+				this->sleeping.store(false);
+			} else {
+				// a producer has claimed the cell but not yet published it
+				guard.unlock();
+				std::this_thread::yield();
+			}
+		}
+	}
+}
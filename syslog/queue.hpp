@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+#include "syslog/logging.hpp"
+#include "syslog/deferred.hpp"
+
+namespace WarGrey::SCADA {
+	private struct SyslogRecord {
+		WarGrey::SCADA::Log level;
+		Platform::String^ message; // `nullptr` if the arguments are captured for deferred formatting
+		Platform::String^ topic;
+		WarGrey::SCADA::SyslogMetainfo meta;
+		WarGrey::SCADA::SyslogArguments args;
+		unsigned long long queued_ticks = 0ULL; // TSC, for measuring the lag of isolated receivers
+	};
+
+	private struct SyslogQueueStatistics {
+		size_t capacity;
+		size_t depth;
+		size_t max_depth;
+		unsigned long long pushed;
+		unsigned long long dispatched;
+		unsigned long long dropped;
+	};
+
+	/** NOTE
+	 * A bounded ring of sequenced cells (Dmitry Vyukov's algorithm), producers never take locks unless
+	 *   the consumer is sleeping or the policy is `Block` and the ring is full.
+	 *
+	 * Cells are also claimable by producers under the `DropOldest` policy, so the ring is actually MPMC.
+	 */
+	private class SyslogQueue {
+	public:
+		virtual ~SyslogQueue() noexcept;
+		SyslogQueue(std::function<void(WarGrey::SCADA::SyslogRecord&)> dispatch, size_t capacity = 4096U,
+			WarGrey::SCADA::SyslogOverflow policy = WarGrey::SCADA::SyslogOverflow::DropOldest);
+
+	public:
+		bool push(WarGrey::SCADA::SyslogRecord& record);
+		void flush();
+		void shutdown();
+
+	public:
+		size_t depth();
+		void statistics(WarGrey::SCADA::SyslogQueueStatistics* stat);
+
+	private:
+		bool try_push(WarGrey::SCADA::SyslogRecord& record);
+		bool try_pop(WarGrey::SCADA::SyslogRecord* record);
+		void release(WarGrey::SCADA::SyslogRecord* record);
+		void consume();
+
+	private:
+		struct Cell {
+			std::atomic<size_t> sequence;
+			WarGrey::SCADA::SyslogRecord record;
+		};
+
+	private:
+		std::vector<WarGrey::SCADA::SyslogQueue::Cell> cells;
+		size_t mask;
+		alignas(64) std::atomic<size_t> enqueue_pos;
+		alignas(64) std::atomic<size_t> dequeue_pos;
+
+	private:
+		std::function<void(WarGrey::SCADA::SyslogRecord&)> dispatch;
+		WarGrey::SCADA::SyslogOverflow policy;
+		std::atomic<bool> sleeping;
+		std::atomic<size_t> blocking;
+		std::atomic<size_t> max_depth;
+		std::atomic<unsigned long long> pushed;
+		std::atomic<unsigned long long> dispatched;
+		std::atomic<unsigned long long> dropped;
+
+	private:
+		std::mutex section;
+		std::condition_variable ready;
+		std::condition_variable space;
+		std::condition_variable drained;
+		std::thread consumer;
+		bool stopping = false;
+	};
+}
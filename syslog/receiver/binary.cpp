@@ -0,0 +1,169 @@
+#include <cstring>
+#include <Windows.h>
+
+#include "syslog/receiver/binary.hpp"
+#include "syslog/deferred.hpp"
+
+#include "datum/time.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+static const size_t binlog_max_pending_size = 1024U * 1024U;
+
+/*************************************************************************************************/
+BinaryLogReceiver::BinaryLogReceiver(Platform::String^ dirname, Platform::String^ prefix, RotationPeriod period, unsigned int count
+	, Log level, Platform::String^ topic)
+	: ISyslogReceiver(level, topic), IRotativeDirectory(dirname, prefix, ".wgbl", period, count) {}
+
+BinaryLogReceiver::~BinaryLogReceiver() {
+	this->dispose();
+
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->closed = true;
+
+	if (this->file != nullptr) {
+		CloseHandle(this->file);
+		this->file = nullptr;
+	}
+}
+
+void BinaryLogReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	std::unique_lock<std::mutex> guard(this->section);
+	long long timestamp = ((data.timepoint > 0LL) ? data.timepoint : current_100nanoseconds());
+	unsigned short topic_id = this->intern_topic(topic, timestamp);
+
+	if ((data.args != nullptr) && (data.args->format != nullptr)) {
+		unsigned char head[sizeof(unsigned int) + sizeof(unsigned short)];
+		unsigned int template_id = this->intern_template(data.args->format, timestamp);
+		unsigned short args_size = data.args->size;
+
+		memcpy(head, &template_id, sizeof(unsigned int));
+		memcpy(head + sizeof(unsigned int), &args_size, sizeof(unsigned short));
+
+		this->write_record(BinaryLogRecordType::Arguments, level, topic_id, timestamp,
+			head, sizeof(head), data.args->pool, args_size);
+	} else if (message != nullptr) {
+		this->write_record(BinaryLogRecordType::Text, level, topic_id, timestamp,
+			nullptr, 0, message->Data(), message->Length() * sizeof(wchar_t));
+	}
+}
+
+void BinaryLogReceiver::on_file_rotated(StorageFile^ prev_file, StorageFile^ current_file, long long timepoint) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (!this->closed) {
+		HANDLE file = CreateFile2(current_file->Path->Data(), FILE_APPEND_DATA, FILE_SHARE_READ, OPEN_ALWAYS, nullptr);
+
+		if (this->file != nullptr) {
+			CloseHandle(this->file);
+			this->file = nullptr;
+
+			// every file is self-contained
+			this->topics.clear();
+			this->templates.clear();
+		}
+
+		if (file != INVALID_HANDLE_VALUE) {
+			LARGE_INTEGER file_size;
+			DWORD written = 0;
+
+			this->file = file;
+
+			if (GetFileSizeEx(file, &file_size) && (file_size.QuadPart == 0LL)) {
+				BinaryLogFileHeader header;
+
+				binary_log_make_file_header(&header, timepoint, this->span_seconds());
+				WriteFile(file, &header, sizeof(BinaryLogFileHeader), &written, nullptr);
+			}
+
+			if (!this->pending.empty()) {
+				WriteFile(file, this->pending.data(), DWORD(this->pending.size()), &written, nullptr);
+				this->pending.clear();
+				this->pending.shrink_to_fit();
+			}
+		}
+	}
+}
+
+void BinaryLogReceiver::on_exception(Platform::Exception^ e) {
+	/** keep silent
+	 * A failed rotation leaves the previous file open and records keep going there,
+	 *   only records before the first file is ready are pending, and those beyond `binlog_max_pending_size` are dropped.
+	 */
+}
+
+/*************************************************************************************************/
+unsigned short BinaryLogReceiver::intern_topic(Platform::String^ topic, long long timestamp) {
+	unsigned short id = 0U;
+
+	if (topic != nullptr) {
+		std::wstring name(topic->Data(), topic->Length());
+		auto it = this->topics.find(name);
+
+		if (it != this->topics.end()) {
+			id = it->second;
+		} else if (this->topics.size() < 0xFFFEU) {
+			id = (unsigned short)(this->topics.size() + 1U);
+			this->topics.insert(std::pair<std::wstring, unsigned short>(name, id));
+			this->write_record(BinaryLogRecordType::Topic, Log::Debug, id, timestamp,
+				nullptr, 0, name.c_str(), name.size() * sizeof(wchar_t));
+		}
+	}
+
+	return id;
+}
+
+unsigned int BinaryLogReceiver::intern_template(const wchar_t* format, long long timestamp) {
+	auto it = this->templates.find(format);
+	unsigned int id = 0U;
+
+	if (it != this->templates.end()) {
+		id = it->second;
+	} else {
+		id = (unsigned int)(this->templates.size() + 1U);
+		this->templates.insert(std::pair<const wchar_t*, unsigned int>(format, id));
+		this->write_record(BinaryLogRecordType::Template, Log::Debug, 0U, timestamp,
+			&id, sizeof(unsigned int), format, wcslen(format) * sizeof(wchar_t));
+	}
+
+	return id;
+}
+
+void BinaryLogReceiver::write_record(BinaryLogRecordType type, Log level, unsigned short topic, long long timestamp
+	, const void* head, size_t head_size, const void* body, size_t body_size) {
+	BinaryLogRecordHeader header;
+	size_t size = sizeof(BinaryLogRecordHeader) + head_size + body_size;
+
+	header.size = (unsigned int)(size);
+	header.type = (unsigned char)(type);
+	header.level = (unsigned char)(level);
+	header.topic = topic;
+	header.timestamp = timestamp;
+
+	this->record.resize(size);
+	memcpy(this->record.data(), &header, sizeof(BinaryLogRecordHeader));
+
+	if (head_size > 0) {
+		memcpy(this->record.data() + sizeof(BinaryLogRecordHeader), head, head_size);
+	}
+
+	if (body_size > 0) {
+		memcpy(this->record.data() + sizeof(BinaryLogRecordHeader) + head_size, body, body_size);
+	}
+
+	if (this->file != nullptr) {
+		DWORD written = 0;
+
+		WriteFile(this->file, this->record.data(), DWORD(size), &written, nullptr);
+	} else if (!this->closed) {
+		// definitions are never dropped since they have been interned
+		bool definition = ((type == BinaryLogRecordType::Topic) || (type == BinaryLogRecordType::Template));
+
+		if (definition || (this->pending.size() + size <= binlog_max_pending_size)) {
+			this->pending.insert(this->pending.end(), this->record.begin(), this->record.end());
+		}
+	}
+}
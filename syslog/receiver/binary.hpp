@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "syslog/logging.hpp"
+#include "syslog/binlog.hpp"
+
+#include "dirotation.hpp"
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * Messages formatted by the deferred mode of `Syslog` are stored as template ids and raw arguments,
+	 *   other messages are stored as texts, topics and templates are interned per file.
+	 */
+	private class BinaryLogReceiver : public WarGrey::SCADA::ISyslogReceiver, public WarGrey::SCADA::IRotativeDirectory {
+	public:
+		BinaryLogReceiver(Platform::String^ dirname = "syslog", Platform::String^ file_prefix = nullptr,
+			WarGrey::SCADA::RotationPeriod period = WarGrey::SCADA::RotationPeriod::Daily, unsigned int period_count = 1U,
+			WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = "");
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		void on_file_rotated(Windows::Storage::StorageFile^ prev_file, Windows::Storage::StorageFile^ current_file, long long timepoint) override;
+		void on_exception(Platform::Exception^ e) override;
+
+	protected:
+		~BinaryLogReceiver() noexcept;
+
+	private:
+		unsigned short intern_topic(Platform::String^ topic, long long timestamp);
+		unsigned int intern_template(const wchar_t* format, long long timestamp);
+		void write_record(WarGrey::SCADA::BinaryLogRecordType type, WarGrey::SCADA::Log level, unsigned short topic, long long timestamp,
+			const void* head, size_t head_size, const void* body, size_t body_size);
+
+	private:
+		std::mutex section;
+		std::map<std::wstring, unsigned short> topics;
+		std::map<const wchar_t*, unsigned int> templates;
+		std::vector<unsigned char> pending;
+		std::vector<unsigned char> record;
+		void* file = nullptr;
+		bool closed = false;
+	};
+}
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <Windows.h>
+
+#include "syslog/receiver/file.hpp"
+
+#include "datum/fixnum.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+/*************************************************************************************************/
+FileReceiver::FileReceiver(Platform::String^ dirname, Platform::String^ prefix, RotationPeriod period, unsigned int count
+	, Log level, Platform::String^ topic, size_t flush_size, long long flush_ms, bool sync)
+	: ISyslogReceiver(level, topic), IRotativeDirectory(dirname, prefix, ".log", period, count)
+	, flush_size(fxmax(flush_size, size_t(1U))), flush_ms(fxmax(flush_ms, 1LL)), sync(sync) {
+	this->counters.written_bytes = 0ULL;
+	this->counters.writes = 0ULL;
+	this->counters.syncs = 0ULL;
+	this->counters.dropped = 0ULL;
+
+	// never hold more than a few seconds of a log storm in memory
+	this->max_pending_size = fxmax(this->flush_size * 64U, size_t(4U * 1024U * 1024U));
+	this->segments.push_back({ nullptr, std::string() });
+	this->writer = std::thread([this]() { this->write_segments(); });
+}
+
+FileReceiver::~FileReceiver() {
+	this->dispose();
+
+	this->section.lock();
+	this->stopping = true;
+	this->section.unlock();
+
+	this->wakeup.notify_all();
+	this->writer.join();
+
+	for (auto it = this->segments.begin(); it != this->segments.end(); it++) {
+		if (it->file != nullptr) {
+			CloseHandle(it->file);
+		}
+	}
+}
+
+void FileReceiver::statistics(FileReceiverStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	(*stat) = this->counters;
+}
+
+void FileReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	Platform::String^ line = "<" + data.timestamp + "> [" + level.ToString() + "] " + message;
+	int size = WideCharToMultiByte(CP_UTF8, 0, line->Data(), int(line->Length()), nullptr, 0, nullptr, nullptr);
+
+	if (size > 0) {
+		std::string utf8(size_t(size) + 1U, '\n');
+		std::unique_lock<std::mutex> guard(this->section);
+
+		WideCharToMultiByte(CP_UTF8, 0, line->Data(), int(line->Length()), &utf8[0], size, nullptr, nullptr);
+
+		if (this->pending_size + utf8.size() > this->max_pending_size) {
+			this->counters.dropped++;
+		} else {
+			std::string* tail = &this->segments.back().data;
+
+			tail->append(utf8);
+			this->pending_size += utf8.size();
+
+			if (tail->size() >= this->flush_size) {
+				this->wakeup.notify_one();
+			}
+		}
+	}
+}
+
+void FileReceiver::on_file_rotated(StorageFile^ prev_file, StorageFile^ current_file, long long timepoint) {
+	HANDLE file = CreateFile2(current_file->Path->Data(), FILE_APPEND_DATA, FILE_SHARE_READ, OPEN_ALWAYS, nullptr);
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+	}
+
+	if (this->stopping) {
+		if (file != nullptr) {
+			CloseHandle(file);
+		}
+	} else if (this->segments.back().file == nullptr) {
+		// lines logged before the first file is ready go to it
+		this->segments.back().file = file;
+	} else {
+		this->segments.push_back({ file, std::string() });
+	}
+
+	this->wakeup.notify_one();
+}
+
+void FileReceiver::on_exception(Platform::Exception^ e) {
+	/** keep silent
+	 * Without a new segment, lines keep being appended to the previous file,
+	 *   or stay in memory if the first file is not ready yet, and those beyond `max_pending_size` are counted as dropped.
+	 */
+}
+
+/*************************************************************************************************/
+void FileReceiver::write_segments() {
+	std::unique_lock<std::mutex> guard(this->section);
+	std::string batch;
+
+	while (true) {
+		bool retired = (this->segments.size() > 1U);
+		void* file = this->segments.front().file;
+
+		if ((!retired) && (!this->stopping) && ((file == nullptr) || (this->segments.front().data.size() < this->flush_size))) {
+			this->wakeup.wait_for(guard, std::chrono::milliseconds(this->flush_ms));
+			retired = (this->segments.size() > 1U);
+			file = this->segments.front().file;
+		}
+
+		if ((file != nullptr) || retired || this->stopping) {
+			batch.swap(this->segments.front().data);
+			this->pending_size -= batch.size();
+
+			if (retired) {
+				this->segments.pop_front();
+			}
+		}
+
+		if (!batch.empty()) {
+			bool okay = false;
+
+			if (file != nullptr) {
+				DWORD written = 0;
+
+				guard.unlock();
+				okay = (WriteFile(file, batch.data(), DWORD(batch.size()), &written, nullptr) != FALSE);
+
+				if (okay && this->sync) {
+					FlushFileBuffers(file);
+				}
+				guard.lock();
+			}
+
+			if (okay) {
+				this->counters.written_bytes += batch.size();
+				this->counters.writes++;
+				this->counters.syncs += (this->sync ? 1U : 0U);
+			}
+
+			batch.clear();
+		}
+
+		if (retired && (file != nullptr)) {
+			CloseHandle(file);
+		}
+
+		if (this->stopping && (this->segments.size() == 1U) && this->segments.front().data.empty()) {
+			break;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <condition_variable>
+
+#include "syslog/logging.hpp"
+
+#include "dirotation.hpp"
+
+namespace WarGrey::SCADA {
+	private struct FileReceiverStatistics {
+		unsigned long long written_bytes;
+		unsigned long long writes;
+		unsigned long long syncs;
+		unsigned long long dropped;
+	};
+
+	/** NOTE
+	 * Producers only append UTF-8 lines to the in-memory segment of the current file,
+	 *   the writer thread writes a segment once it reaches `flush_size` bytes or `flush_ms` after the last write,
+	 *   and then syncs the file once for the whole group.
+	 *
+	 * Rotating closes the current segment and opens a new one bound to the new file,
+	 *   so that lines logged after `on_file_rotated` never go to the previous file,
+	 *   and producers are never blocked by opening, writing or closing files.
+	 */
+	private class FileReceiver : public WarGrey::SCADA::ISyslogReceiver, public WarGrey::SCADA::IRotativeDirectory {
+	public:
+		FileReceiver(Platform::String^ dirname = "syslog", Platform::String^ file_prefix = nullptr,
+			WarGrey::SCADA::RotationPeriod period = WarGrey::SCADA::RotationPeriod::Daily, unsigned int period_count = 1U,
+			WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = "",
+			size_t flush_size = 64U * 1024U, long long flush_ms = 1000LL, bool sync = true);
+
+	public:
+		void statistics(WarGrey::SCADA::FileReceiverStatistics* stat);
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		void on_file_rotated(Windows::Storage::StorageFile^ prev_file, Windows::Storage::StorageFile^ current_file, long long timepoint) override;
+		void on_exception(Platform::Exception^ e) override;
+
+	protected:
+		~FileReceiver() noexcept;
+
+	private:
+		void write_segments();
+
+	private:
+		struct Segment {
+			void* file;
+			std::string data;
+		};
+
+	private:
+		std::mutex section;
+		std::condition_variable wakeup;
+		std::deque<WarGrey::SCADA::FileReceiver::Segment> segments;
+		size_t pending_size = 0U;
+		std::thread writer;
+		bool stopping = false;
+
+	private:
+		WarGrey::SCADA::FileReceiverStatistics counters;
+		size_t flush_size;
+		size_t max_pending_size;
+		long long flush_ms;
+		bool sync;
+	};
+}
@@ -0,0 +1,177 @@
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <exception>
+#include <Windows.h>
+
+#include "syslog/receiver/flight.hpp"
+
+#include "datum/enum.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+static const char* flight_level_names[] = { "Debug", "Info", "Notice", "Warning", "Error", "Critical", "Alarm", "Panic" };
+static const char flight_dump_banner[] = "==== flight recorder ====\n";
+static const int flight_fatal_signals[] = { SIGABRT, SIGSEGV, SIGILL, SIGFPE };
+
+static std::atomic<FlightRecorder*> installed_recorder(nullptr);
+static std::atomic<bool> handlers_hooked(false);
+static std::terminate_handler prev_terminate_handler = nullptr;
+
+/** NOTE
+ * Windows has no POSIX signals to speak of, crashes are reported via `std::terminate` and the CRT signals,
+ *   handlers only touch the preallocated slots and the preopened handle.
+ */
+static void flight_on_terminate() {
+	flight_recorder_dump();
+
+	if (prev_terminate_handler != nullptr) {
+		prev_terminate_handler();
+	}
+
+	abort();
+}
+
+static void __cdecl flight_on_signal(int sig) {
+	flight_recorder_dump();
+
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+static size_t flight_append(char* dest, size_t size, size_t capacity, const char* src) {
+	size_t n = strlen(src);
+
+	if (size + n > capacity) {
+		n = capacity - size;
+	}
+
+	memcpy(dest + size, src, n);
+
+	return size + n;
+}
+
+static size_t flight_append(char* dest, size_t size, size_t capacity, Platform::String^ src) {
+	if (src != nullptr) {
+		// a UTF-16 unit never takes more than 3 bytes in UTF-8, so that the conversion never overflows
+		int length = int(src->Length());
+		int fit = int((capacity - size) / 3U);
+		int n = WideCharToMultiByte(CP_UTF8, 0, src->Data(), ((length < fit) ? length : fit),
+			dest + size, int(capacity - size), nullptr, nullptr);
+
+		if (n > 0) {
+			size += size_t(n);
+		}
+	}
+
+	return size;
+}
+
+/*************************************************************************************************/
+FlightRecorder::FlightRecorder(Platform::String^ name, unsigned int slot_count, Log level, Platform::String^ topic)
+	: ISyslogReceiver(level, topic), slot_count((slot_count == 0U) ? 1U : slot_count), sequence(0ULL), dumped(0ULL) {
+	Platform::String^ path = ApplicationData::Current->LocalFolder->Path + "\\" + name + ".crash";
+	HANDLE file = CreateFile2(path->Data(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, OPEN_ALWAYS, nullptr);
+
+	this->slots = new FlightRecorder::Slot[this->slot_count];
+
+	for (unsigned int idx = 0; idx < this->slot_count; idx++) {
+		this->slots[idx].stamp.store(0ULL, std::memory_order_relaxed);
+		this->slots[idx].size = 0U;
+	}
+
+	if (file != INVALID_HANDLE_VALUE) {
+		this->file = file;
+	}
+}
+
+FlightRecorder::~FlightRecorder() {
+	FlightRecorder* self = this;
+
+	installed_recorder.compare_exchange_strong(self, nullptr);
+
+	if (this->file != nullptr) {
+		CloseHandle(this->file);
+		this->file = nullptr;
+	}
+
+	delete[] this->slots;
+}
+
+bool FlightRecorder::is_open() {
+	return (this->file != nullptr);
+}
+
+void FlightRecorder::install() {
+	installed_recorder.store(this);
+
+	if (!handlers_hooked.exchange(true)) {
+		prev_terminate_handler = std::set_terminate(flight_on_terminate);
+
+		for (size_t idx = 0; idx < sizeof(flight_fatal_signals) / sizeof(int); idx++) {
+			signal(flight_fatal_signals[idx], flight_on_signal);
+		}
+	}
+}
+
+void FlightRecorder::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	unsigned long long seq = this->sequence.fetch_add(1ULL, std::memory_order_relaxed);
+	FlightRecorder::Slot* slot = &this->slots[seq % this->slot_count];
+	size_t capacity = sizeof(slot->line) - 1U;
+	size_t size = 0U;
+
+	slot->stamp.store(0ULL, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	size = flight_append(slot->line, size, capacity, "<");
+	size = flight_append(slot->line, size, capacity, data.timestamp);
+	size = flight_append(slot->line, size, capacity, "> [");
+	size = flight_append(slot->line, size, capacity, flight_level_names[_I(level) % (sizeof(flight_level_names) / sizeof(char*))]);
+	size = flight_append(slot->line, size, capacity, "] ");
+	size = flight_append(slot->line, size, capacity, message);
+	slot->line[size++] = '\n';
+	slot->size = (unsigned int)(size);
+
+	slot->stamp.store(seq + 1ULL, std::memory_order_release);
+
+	if (level == Log::Panic) {
+		this->dump();
+	}
+}
+
+void FlightRecorder::dump() {
+	unsigned long long end = this->sequence.load(std::memory_order_acquire);
+	unsigned long long start = this->dumped.exchange(end);
+
+	if ((this->file != nullptr) && (end > start)) {
+		DWORD written = 0;
+
+		if (end - start > this->slot_count) {
+			start = end - this->slot_count;
+		}
+
+		WriteFile(this->file, flight_dump_banner, DWORD(sizeof(flight_dump_banner) - 1U), &written, nullptr);
+
+		for (unsigned long long seq = start; seq < end; seq++) {
+			FlightRecorder::Slot* slot = &this->slots[seq % this->slot_count];
+
+			// slots being written or already overwritten by newer records are skipped
+			if (slot->stamp.load(std::memory_order_acquire) == seq + 1ULL) {
+				WriteFile(this->file, slot->line, DWORD(slot->size), &written, nullptr);
+			}
+		}
+
+		FlushFileBuffers(this->file);
+	}
+}
+
+/*************************************************************************************************/
+void WarGrey::SCADA::flight_recorder_dump() {
+	FlightRecorder* recorder = installed_recorder.load();
+
+	if (recorder != nullptr) {
+		recorder->dump();
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+#include "syslog/logging.hpp"
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * A flight recorder keeps the latest `slot_count` records as UTF-8 lines in slots preallocated at construction,
+	 *   recording a message takes one atomic increment and one bounded conversion, no lock, no allocation and no syscall,
+	 *   lines longer than a slot are truncated.
+	 *
+	 * The dump file (`LocalFolder\name.crash`) is opened at construction too,
+	 *   so that `dump` only calls `WriteFile` and `FlushFileBuffers` on that handle and is safe to call from crash handlers,
+	 *   every dump appends the records that have not been dumped yet.
+	 *
+	 * The recorder dumps itself on `Log::Panic`,
+	 *   and `install` makes it the one dumped by `std::terminate`, `abort` and fatal CRT signals of the process.
+	 */
+	private class FlightRecorder : public WarGrey::SCADA::ISyslogReceiver {
+	public:
+		FlightRecorder(Platform::String^ name = "flight", unsigned int slot_count = 1024U,
+			WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = "");
+
+	public:
+		void install();
+		void dump();
+		bool is_open();
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		~FlightRecorder() noexcept;
+
+	private:
+		struct Slot {
+			std::atomic<unsigned long long> stamp; // sequence + 1 once the line is complete, 0 while writing
+			unsigned int size;
+			char line[244];
+		};
+
+	private:
+		WarGrey::SCADA::FlightRecorder::Slot* slots;
+		unsigned int slot_count;
+		void* file = nullptr;
+
+	private:
+		std::atomic<unsigned long long> sequence;
+		std::atomic<unsigned long long> dumped;
+	};
+
+	// dump the installed recorder, if any, it is safe to call from crash handlers
+	void flight_recorder_dump();
+}
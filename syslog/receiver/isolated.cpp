@@ -0,0 +1,62 @@
+#include "syslog/receiver/isolated.hpp"
+#include "syslog/queue.hpp"
+#include "syslog/metrics.hpp"
+
+#include "datum/time.hpp"
+
+using namespace WarGrey::SCADA;
+
+/*************************************************************************************************/
+IsolatedReceiver::IsolatedReceiver(ISyslogReceiver* receiver, size_t capacity, SyslogOverflow policy)
+	: ISyslogReceiver(receiver->level, receiver->topic), receiver(receiver) {
+	this->lag = new SyslogHistogram();
+
+	this->queue = new SyslogQueue([this](SyslogRecord& record) {
+		if (record.meta.args != nullptr) {
+			record.meta.args = &record.args;
+		}
+
+		this->lag->record(current_tsc_ticks() - record.queued_ticks);
+		this->receiver->log_message(record.level, record.message, record.meta, record.topic);
+	}, capacity, policy);
+}
+
+IsolatedReceiver::~IsolatedReceiver() {
+	// the pending messages are delivered before the consumer exits
+	delete this->queue;
+	delete this->lag;
+}
+
+void IsolatedReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	SyslogRecord record;
+
+	record.level = level;
+	record.message = message;
+	record.topic = topic;
+	record.meta = data;
+
+	if (data.args != nullptr) {
+		// the captured arguments live in the caller's record
+		record.args = (*data.args);
+	}
+
+	record.queued_ticks = current_tsc_ticks();
+	this->queue->push(record);
+
+	if (level == Log::Panic) {
+		// the wrapped receiver should have everything before the process goes down
+		this->queue->flush();
+	}
+}
+
+void IsolatedReceiver::flush() {
+	this->queue->flush();
+}
+
+void IsolatedReceiver::statistics(SyslogQueueStatistics* stat) {
+	this->queue->statistics(stat);
+}
+
+void IsolatedReceiver::snapshot_lag(SyslogHistogramSnapshot* snapshot) {
+	this->lag->snapshot(snapshot);
+}
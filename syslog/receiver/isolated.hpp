@@ -0,0 +1,41 @@
+#pragma once
+
+#include "syslog/logging.hpp"
+
+namespace WarGrey::SCADA {
+	class SyslogQueue;
+	class SyslogHistogram;
+	struct SyslogQueueStatistics;
+	struct SyslogHistogramSnapshot;
+
+	/** NOTE
+	 * Attach a receiver through its own bounded queue and thread, so that a stalled sink (say, an unreachable UDP target)
+	 *   only drops or delays its own messages instead of blocking the logger and the other receivers.
+	 *
+	 * The isolated receiver takes the level and the topic of the wrapped one, and holds a reference of it.
+	 * The lag is the time a message spends in the queue before the wrapped receiver takes it.
+	 * Logging a `Panic` message waits until the wrapped receiver has taken everything up to it.
+	 */
+	private class IsolatedReceiver : public WarGrey::SCADA::ISyslogReceiver {
+	public:
+		IsolatedReceiver(WarGrey::SCADA::ISyslogReceiver* receiver, size_t capacity = 1024U,
+			WarGrey::SCADA::SyslogOverflow policy = WarGrey::SCADA::SyslogOverflow::DropOldest);
+
+	public:
+		void flush();
+		void statistics(WarGrey::SCADA::SyslogQueueStatistics* stat);
+		void snapshot_lag(WarGrey::SCADA::SyslogHistogramSnapshot* snapshot);
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		~IsolatedReceiver() noexcept;
+
+	private:
+		WarGrey::SCADA::SharedReference<WarGrey::SCADA::ISyslogReceiver> receiver;
+		WarGrey::SCADA::SyslogQueue* queue;
+		WarGrey::SCADA::SyslogHistogram* lag;
+	};
+}
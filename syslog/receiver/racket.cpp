@@ -1,6 +1,12 @@
 ﻿#include <ppltasks.h>
+#include <Windows.h>
 
 #include "syslog/receiver/racket.hpp"
+#include "syslog/receiver/spool.hpp"
+
+#include "datum/fixnum.hpp"
+
+#include "timewheel.hpp"
 
 using namespace WarGrey::SCADA;
 
@@ -9,68 +15,491 @@ using namespace Windows::Networking;
 using namespace Windows::Networking::Sockets;
 using namespace Windows::Storage::Streams;
 
-static void send_to(IDataWriter^ udpout, Platform::String^ ts, Platform::String^ level, Platform::String^ msg) {
-	udpout->WriteByte('<');
-	udpout->WriteString(ts);
-	udpout->WriteString(L"> [");
-	udpout->WriteString(level);
-	udpout->WriteString(L"] ");
-	udpout->WriteString(msg);
-	udpout->StoreAsync();
+static const size_t max_queued_lines = 1024U;
+static const size_t max_spooling_lines = 4096U;
+static const long long reconnect_interval_ms = 5000LL;
+
+static size_t utf8_size(Platform::String^ src) {
+	const wchar_t* wstr = src->Data();
+	unsigned int length = src->Length();
+	size_t size = 0U;
+
+	for (unsigned int idx = 0; idx < length; idx++) {
+		wchar_t ch = wstr[idx];
+
+		if (ch < 0x80) {
+			size += 1U;
+		} else if (ch < 0x800) {
+			size += 2U;
+		} else if ((ch >= 0xD800) && (ch <= 0xDBFF) && (idx + 1 < length)) { // surrogate pair
+			size += 4U;
+			idx++;
+		} else {
+			size += 3U;
+		}
+	}
+
+	return size;
 }
 
-RacketReceiver::RacketReceiver(Platform::String^ server, unsigned short service, Log level, Platform::String^ topic)
-	: ISyslogReceiver(level, topic) {
-	auto logserver = ref new HostName(server);
+namespace {
+	private class RacketFlusher : public ITimingWheelTask {
+	public:
+		RacketFlusher(RacketReceiver* master) : master(master) {}
 
-	this->client = ref new DatagramSocket();
-	create_task(this->client->ConnectAsync(logserver, service.ToString())).then([this](task<void> conn) {
-		try {
-			conn.get();
+	public:
+		void on_timeout(long long now_ms) override {
+			this->master->flush();
+		}
+
+	private:
+		RacketReceiver* master;
+	};
+
+	private class RacketReplayer : public ITimingWheelTask {
+	public:
+		RacketReplayer(RacketReceiver* master) : master(master) {}
+
+	public:
+		void on_timeout(long long now_ms) override {
+			this->master->replay();
+		}
+
+	private:
+		RacketReceiver* master;
+	};
+}
+
+namespace WarGrey::SCADA {
+	private class RacketSpooler : public ITimingWheelTask {
+	public:
+		RacketSpooler(RacketReceiver* master) : master(master) {}
+
+	public:
+		void on_timeout(long long now_ms) override {
+			std::unique_lock<std::mutex> serial(this->master->spool_section);
+
+			this->master->drain_spool();
+		}
+
+	private:
+		RacketReceiver* master;
+	};
+}
+
+/*************************************************************************************************/
+RacketReceiver::RacketReceiver(Platform::String^ server, unsigned short service, Log level, Platform::String^ topic
+	, size_t mtu, long long flush_ms) : ISyslogReceiver(level, topic), mtu(fxmax(mtu, size_t(64U))), flush_ms(flush_ms) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->logserver = ref new HostName(server);
+	this->service = service.ToString();
+	this->flusher = new RacketFlusher(this);
+	this->connect();
+}
+
+RacketReceiver::~RacketReceiver() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->closing = true;
+
+	if (this->connection != nullptr) {
+		this->connection->Cancel();
+	}
+
+	if (this->storing != nullptr) {
+		this->storing->Cancel();
+	}
+
+	guard.unlock();
+
+	// timers firing right now see `closing` and do nothing
+	TimingWheel::shared()->cancel(this->flusher);
+	delete this->flusher;
+
+	if (this->replayer != nullptr) {
+		TimingWheel::shared()->cancel(this->replayer);
+		TimingWheel::shared()->cancel(this->spooler);
+		delete this->replayer;
+		delete this->spooler;
+	}
+
+	guard.lock();
+	this->settled.wait(guard, [this]() { return (this->inflight == 0U); });
+	guard.unlock();
+
+	if (this->spool != nullptr) {
+		std::unique_lock<std::mutex> serial(this->spool_section);
+
+		// the rest will be replayed by the next run
+		this->drain_spool();
+		delete this->spool;
+	}
+}
+
+void RacketReceiver::enable_spool(Platform::String^ dirname, unsigned long long max_size, unsigned int replay_datagrams_per_second) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (this->spool == nullptr) {
+		this->spool = new SyslogSpool(dirname, "racket", max_size);
+		this->replayer = new RacketReplayer(this);
+		this->spooler = new RacketSpooler(this);
+		this->replay_interval_ms = fxmax(1000LL / fxmax(replay_datagrams_per_second, 1U), 1LL);
+
+		// segments left by the previous run
+		TimingWheel::shared()->arm(this->replayer, reconnect_interval_ms);
+	}
+}
+
+bool RacketReceiver::spool_statistics(SyslogSpoolStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+	bool spooled = (this->spool != nullptr);
+
+	if (spooled) {
+		this->spool->statistics(stat);
+	}
+
+	return spooled;
+}
+
+void RacketReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	Platform::String^ line = "<" + data.timestamp + "> [" + level.ToString() + "] " + message;
+	size_t size = utf8_size(line);
+	std::unique_lock<std::mutex> guard(this->section);
+	bool first = this->lines.empty();
+
+	if (this->spooling || ((this->udpout == nullptr) && (!this->connecting))) {
+		// keep the order, and fall back to the memory queue if the spool is not ready
+		if (this->spool_line(line)) {
+			return;
+		}
+	}
+
+	// connected or not, producers might outpace the link
+	if (this->lines.size() >= max_queued_lines) {
+		if (!this->spill()) {
+			this->queued_size -= this->line_sizes.front() + 1U;
+			this->lines.pop_front();
+			this->line_sizes.pop_front();
+			this->dropped++;
+		} else if (this->spool_line(line)) {
+			return;
+		}
+
+		first = this->lines.empty();
+	}
+
+	this->lines.push_back(line);
+	this->line_sizes.push_back(size);
+	this->queued_size += size + 1U;
+
+	if (this->queued_size >= this->mtu) {
+		this->send_batch();
+	} else if (first) {
+		TimingWheel::shared()->arm(this->flusher, this->flush_ms);
+	}
+}
+
+void RacketReceiver::flush() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (!this->closing) {
+		this->overdue = true;
+		this->send_batch();
+	}
+}
+
+unsigned long long RacketReceiver::dropped_count() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	return this->dropped;
+}
+
+void RacketReceiver::replay() {
+	std::unique_lock<std::mutex> serial(this->spool_section);
+	std::unique_lock<std::mutex> guard(this->section, std::defer_lock);
+	long long next_ms = this->replay_interval_ms;
+
+	// lines waiting for the disk are older than the ones being logged from now on
+	this->drain_spool();
+	guard.lock();
+
+	if (this->closing || (this->spool == nullptr)) {
+		return;
+	}
 
-			udpout = ref new DataWriter(client->OutputStream);
+	if (this->udpout == nullptr) {
+		if (!this->connecting) {
+			this->connect();
+		}
+
+		next_ms = reconnect_interval_ms;
+	} else if (!this->sending) {
+		size_t size = 0U;
+
+		// take the socket, and read the spool without blocking producers
+		this->sending = true;
+		guard.unlock();
+		size = this->spool->peek(this->datagram, this->mtu);
+		guard.lock();
+		this->sending = false;
+
+		if (this->closing) {
+			return;
+		} else if (size > 0U) {
+			// also for segments left by the previous run
+			this->spooling = true;
+			this->udpout->WriteBytes(Platform::ArrayReference<unsigned char>(
+				reinterpret_cast<unsigned char*>(&this->datagram[0]), (unsigned int)(this->datagram.size())));
+			this->sending = true;
+			this->storing = this->udpout->StoreAsync();
+			this->inflight++;
+
+			create_task(this->storing).then([this, size](task<unsigned int> storing) {
+				bool okay = true;
 
-			this->section.lock();
-			while (!this->timestamps.empty()) {
-				auto ts = this->timestamps.front();
-				auto lvl = this->levels.front();
-				auto msg = this->messages.front();
+				try {
+					storing.get();
+				} catch (Platform::Exception^ e) {
+					okay = false;
+				} catch (task_canceled&) {
+					okay = false;
+				}
 
-				send_to(udpout, ts, lvl, msg);
+				this->on_replay_sent(size, okay);
+			}, task_continuation_context::use_arbitrary());
+		} else if (this->spool_inbox.empty()) {
+			// all caught up, and the memory queue takes over
+			this->spooling = false;
+			this->send_batch();
+		}
+	}
+
+	if (this->spooling || (this->udpout == nullptr)) {
+		TimingWheel::shared()->arm(this->replayer, next_ms);
+	}
+}
 
-				this->timestamps.pop();
-				this->levels.pop();
-				this->messages.pop();
-			};
-			this->section.unlock();
+/*************************************************************************************************/
+void RacketReceiver::connect() {
+	this->connecting = true;
+	this->client = ref new DatagramSocket();
+	this->connection = this->client->ConnectAsync(this->logserver, this->service);
+	this->inflight++;
+
+	create_task(this->connection).then([this](task<void> conn) {
+		bool okay = true;
+
+		try {
+			conn.get();
 		} catch (Platform::Exception^ e) {
 			/** keep silent: No such host is known.
 			 * It occurs when
 			 *   1). there is no network connection
 			 *   2). target is not a unicast address
 			 */
+			okay = false;
+		} catch (task_canceled&) {
+			okay = false;
 		}
-	});
+
+		this->on_connected(okay);
+	}, task_continuation_context::use_arbitrary());
 }
 
-void RacketReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
-	Platform::String^ timestamp = data.timestamp;
+bool RacketReceiver::spool_line(Platform::String^ line) {
+	bool okay = (this->spool != nullptr);
+
+	if (okay) {
+		if (this->spool_inbox.empty()) {
+			TimingWheel::shared()->arm(this->spooler, this->flush_ms);
+		}
+
+		this->spool_inbox.push_back(line);
+
+		if (this->spool_inbox.size() > max_spooling_lines) {
+			this->spool_inbox.pop_front();
+			this->dropped++;
+		}
+
+		if (!this->spooling) {
+			this->spooling = true;
+			TimingWheel::shared()->arm(this->replayer, this->replay_interval_ms);
+		}
+	}
+
+	return okay;
+}
+
+bool RacketReceiver::spill() {
+	bool okay = (this->spool != nullptr);
+
+	while (okay && (!this->lines.empty())) {
+		okay = this->spool_line(this->lines.front());
+
+		if (okay) {
+			this->queued_size -= this->line_sizes.front() + 1U;
+			this->lines.pop_front();
+			this->line_sizes.pop_front();
+		}
+	}
+
+	return okay;
+}
+
+void RacketReceiver::drain_spool() {
+	std::deque<Platform::String^> batch;
+	std::unique_lock<std::mutex> guard(this->section);
+	SyslogSpool* spool = this->spool;
+
+	while ((spool != nullptr) && (!this->spool_inbox.empty())) {
+		batch.swap(this->spool_inbox);
+		guard.unlock();
+
+		while (!batch.empty()) {
+			Platform::String^ line = batch.front();
+			int size = WideCharToMultiByte(CP_UTF8, 0, line->Data(), int(line->Length()), nullptr, 0, nullptr, nullptr);
+
+			this->datagram.resize(size_t(fxmax(size, 0)));
 
-	if (udpout == nullptr) {
-		this->section.lock();
+			if (size > 0) {
+				WideCharToMultiByte(CP_UTF8, 0, line->Data(), int(line->Length()), &this->datagram[0], size, nullptr, nullptr);
+			}
 
-		if (this->levels.size() > 1024) {
-			this->timestamps.pop();
-			this->levels.pop();
-			this->messages.pop();
+			if (!spool->append(this->datagram.data(), this->datagram.size())) {
+				break;
+			}
+
+			batch.pop_front();
+		}
+
+		guard.lock();
+
+		if (!batch.empty()) { // the first segment is not ready yet
+			this->spool_inbox.insert(this->spool_inbox.begin(), batch.begin(), batch.end());
+			batch.clear();
+
+			while (this->spool_inbox.size() > max_spooling_lines) {
+				this->spool_inbox.pop_front();
+				this->dropped++;
+			}
+
+			if (!this->closing) {
+				TimingWheel::shared()->arm(this->spooler, this->flush_ms);
+			}
+
+			break;
+		}
+	}
+}
+
+/*************************************************************************************************/
+void RacketReceiver::send_batch() {
+	if ((this->udpout != nullptr) && (!this->sending) && (!this->lines.empty())) {
+		size_t size = 0U;
+
+		do {
+			if (size > 0U) {
+				this->udpout->WriteByte('\n');
+				size += 1U;
+			}
+
+			this->udpout->WriteString(this->lines.front());
+			size += this->line_sizes.front();
+
+			this->queued_size -= this->line_sizes.front() + 1U;
+			this->lines.pop_front();
+			this->line_sizes.pop_front();
+		} while ((!this->lines.empty()) && (size + 1U + this->line_sizes.front() <= this->mtu));
+
+		this->sending = true;
+		this->overdue = false;
+
+		if (!this->lines.empty()) {
+			TimingWheel::shared()->arm(this->flusher, this->flush_ms);
+		}
+
+		this->storing = this->udpout->StoreAsync();
+		this->inflight++;
+
+		create_task(this->storing).then([this](task<unsigned int> storing) {
+			bool okay = true;
+
+			try {
+				storing.get();
+			} catch (Platform::Exception^ e) {
+				// the datagram is lost, the rest will be spooled if possible
+				okay = false;
+			} catch (task_canceled&) {
+				okay = false;
+			}
+
+			this->on_batch_sent(okay);
+		}, task_continuation_context::use_arbitrary());
+	}
+}
+
+void RacketReceiver::on_connected(bool okay) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->connecting = false;
+	this->connection = nullptr;
+	this->inflight--;
+
+	if (this->closing) {
+		this->settled.notify_all();
+	} else if (okay) {
+		this->udpout = ref new DataWriter(this->client->OutputStream);
+
+		if (!this->spooling) {
+			this->send_batch();
 		}
+	} else if (this->spool != nullptr) {
+		this->client = nullptr;
+		this->spill();
+		TimingWheel::shared()->arm(this->replayer, reconnect_interval_ms);
+	}
+}
+
+void RacketReceiver::on_batch_sent(bool okay) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->sending = false;
+	this->storing = nullptr;
+	this->inflight--;
+
+	if (this->closing) {
+		this->settled.notify_all();
+	} else if ((!okay) && (this->spool != nullptr)) {
+		// reconnect later, in case that the network interface has changed
+		this->udpout = nullptr;
+		this->client = nullptr;
+		this->spill();
+		TimingWheel::shared()->arm(this->replayer, reconnect_interval_ms);
+	} else if (this->overdue || (this->queued_size >= this->mtu)) {
+		this->send_batch();
+	}
+}
+
+void RacketReceiver::on_replay_sent(size_t size, bool okay) {
+	if (okay) {
+		/** NOTE
+		 * The spool outlives inflight stores, and no one else touches its head while `sending`.
+		 */
+		this->spool->consume(size);
+	}
+
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->sending = false;
+	this->storing = nullptr;
+	this->inflight--;
 
-		this->levels.push(level.ToString());
-		this->messages.push(message);
-		this->timestamps.push(timestamp);
-		
-		this->section.unlock();
-	} else {
-		send_to(udpout, timestamp, level.ToString(), message);
+	if (this->closing) {
+		this->settled.notify_all();
+	} else if (!okay) {
+		// the lines stay in the spool and will be replayed after reconnecting
+		this->udpout = nullptr;
+		this->client = nullptr;
 	}
 }
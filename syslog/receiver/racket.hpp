@@ -1,31 +1,112 @@
 #pragma once
 
-#include <queue>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
+#include <string>
 
 #include "syslog/logging.hpp"
 
 namespace WarGrey::SCADA {
+	class ITimingWheelTask;
+	class RacketSpooler;
+	class SyslogSpool;
+	struct SyslogSpoolStatistics;
+
+	/** NOTE
+	 * Lines are packed into datagrams of at most `mtu` bytes (UTF-8) separated by '\n',
+	 *   a datagram is sent once it is full or `flush_ms` after its first line has been queued,
+	 *   and there is at most one `StoreAsync` in flight.
+	 *
+	 * A line longer than `mtu` is sent in its own datagram.
+	 *
+	 * The memory queue holds at most 1024 lines whatever the state of the link, in case that producers outpace it,
+	 *   the oldest lines are spilled to the spool if it is enabled, or dropped and counted otherwise.
+	 *
+	 * With the spool enabled, lines go to disk once the collector is unreachable or the memory queue is full,
+	 *   and they are replayed (at most `replay_datagrams_per_second`) once the link is back,
+	 *   lines logged in the meantime go after them, so that the collector still receives them in order.
+	 *
+	 * Spooled lines are handed to the thread of the timing wheel (at most 4096 lines are waiting there),
+	 *   which does all the disk I/O of the spool, so that producers never wait on the disk.
+	 *
+	 * The destructor cancels the pending socket operations and waits for their continuations,
+	 *   which run on the thread pool rather than the thread that logs.
+	 */
 	private class RacketReceiver : public WarGrey::SCADA::ISyslogReceiver {
+		friend class WarGrey::SCADA::RacketSpooler;
+
 	public:
 		RacketReceiver(Platform::String^ server, unsigned short service,
 			WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug,
-			Platform::String^ topic = "");
+			Platform::String^ topic = "", size_t mtu = 1400U, long long flush_ms = 20LL);
+
+	public:
+		void flush();
+		unsigned long long dropped_count();
+
+	public:
+		// enable it before the receiver is attached to loggers
+		void enable_spool(Platform::String^ dirname = "racket", unsigned long long max_size = 256ULL * 1024ULL * 1024ULL,
+			unsigned int replay_datagrams_per_second = 50U);
+		bool spool_statistics(WarGrey::SCADA::SyslogSpoolStatistics* stat);
+		void replay(); // does nothing if the spool is not enabled
 
 	protected:
 		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
 			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
 
 	protected:
-		~RacketReceiver() noexcept {}
+		~RacketReceiver() noexcept;
+
+	private: // with `section` locked
+		void connect();
+		void send_batch();
+		bool spool_line(Platform::String^ line);
+		bool spill();
+
+	private: // with `spool_section` locked
+		void drain_spool();
+
+	private: // continuations of the in-flight operations
+		void on_connected(bool okay);
+		void on_batch_sent(bool okay);
+		void on_replay_sent(size_t size, bool okay);
 
 	private:
 		std::mutex section;
-		std::queue<Platform::String^> timestamps;
-		std::queue<Platform::String^> levels;
-		std::queue<Platform::String^> messages;
+		std::condition_variable settled;
+		unsigned int inflight = 0U;
+		bool closing = false;
+		std::deque<Platform::String^> lines;
+		std::deque<size_t> line_sizes;
+		size_t queued_size = 0U;
+		bool sending = false;
+		bool overdue = false;
+		bool connecting = false;
+		bool spooling = false;
+		unsigned long long dropped = 0ULL;
 
+	private:
+		Windows::Networking::HostName^ logserver;
+		Platform::String^ service;
 		Windows::Networking::Sockets::DatagramSocket^ client = nullptr;
 		Windows::Storage::Streams::IDataWriter^ udpout = nullptr;
+		Windows::Foundation::IAsyncAction^ connection = nullptr;
+		Windows::Foundation::IAsyncOperation<unsigned int>^ storing = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* flusher = nullptr;
+		size_t mtu;
+		long long flush_ms;
+
+	private:
+		WarGrey::SCADA::SyslogSpool* spool = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* replayer = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* spooler = nullptr;
+		std::deque<Platform::String^> spool_inbox;
+
+	private: // serializes the disk I/O of the spool
+		std::mutex spool_section;
+		std::string datagram;
+		long long replay_interval_ms = 20LL;
 	};
 }
@@ -0,0 +1,116 @@
+#include <algorithm>
+
+#include "syslog/receiver/recent.hpp"
+
+using namespace WarGrey::SCADA;
+
+static inline std::wstring topic_key(Platform::String^ topic) {
+	return ((topic == nullptr) ? std::wstring() : std::wstring(topic->Data(), topic->Length()));
+}
+
+/*************************************************************************************************/
+RecentLogReceiver::RecentLogReceiver(size_t capacity, Log level, Platform::String^ topic)
+	: ISyslogReceiver(level, topic), ring((capacity > 0U) ? capacity : 1U) {
+	for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+		this->levels.heads[idx] = 0ULL;
+	}
+}
+
+void RecentLogReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	std::unique_lock<std::shared_mutex> guard(this->section);
+	std::wstring key = topic_key(topic);
+	auto chains = this->topics.find(key);
+	unsigned long long seq = ++this->sequence;
+	RecentLogReceiver::Slot* self = &this->ring[seq % this->ring.size()];
+
+	if (chains == this->topics.end()) {
+		RecentLogReceiver::Chains heads;
+
+		for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+			heads.heads[idx] = 0ULL;
+		}
+
+		chains = this->topics.insert(std::pair<std::wstring, RecentLogReceiver::Chains>(key, heads)).first;
+	}
+
+	self->record.sequence = seq;
+	self->record.level = level;
+	self->record.topic = topic;
+	self->record.message = message;
+	self->record.timestamp = data.timestamp;
+	self->record.timepoint = data.timepoint;
+
+	self->prev_of_level = this->levels.heads[_I(level)];
+	this->levels.heads[_I(level)] = seq;
+	self->prev_of_topic = chains->second.heads[_I(level)];
+	chains->second.heads[_I(level)] = seq;
+}
+
+size_t RecentLogReceiver::query(std::vector<RecentLogRecord>& records, size_t count, Log min_level, Platform::String^ topic, unsigned long long since) {
+	std::shared_lock<std::shared_mutex> guard(this->section);
+	const RecentLogReceiver::Chains* chains = &this->levels;
+	unsigned long long cursors[_N(Log)];
+	size_t found = 0U;
+
+	if (topic != nullptr) {
+		auto it = this->topics.find(topic_key(topic));
+
+		chains = ((it == this->topics.end()) ? nullptr : &it->second);
+	}
+
+	if (chains != nullptr) {
+		size_t first = records.size();
+
+		for (unsigned int idx = 0U; idx < _N(Log); idx++) {
+			cursors[idx] = ((idx >= _I(min_level)) ? chains->heads[idx] : 0ULL);
+		}
+
+		while (found < count) {
+			const RecentLogReceiver::Slot* self = nullptr;
+			unsigned int latest = 0U;
+
+			// merge the chains from the newest to the oldest
+			for (unsigned int idx = _I(min_level); idx < _N(Log); idx++) {
+				if (cursors[idx] > cursors[latest]) {
+					latest = idx;
+				}
+			}
+
+			if (cursors[latest] <= since) {
+				break;
+			}
+
+			self = this->find_slot(cursors[latest]);
+
+			if (self == nullptr) {
+				// the rest of the chain has been overwritten too
+				cursors[latest] = 0ULL;
+			} else {
+				records.push_back(self->record);
+				cursors[latest] = ((topic == nullptr) ? self->prev_of_level : self->prev_of_topic);
+				found++;
+			}
+		}
+
+		std::reverse(records.begin() + first, records.end());
+	}
+
+	return found;
+}
+
+unsigned long long RecentLogReceiver::last_sequence() {
+	std::shared_lock<std::shared_mutex> guard(this->section);
+
+	return this->sequence;
+}
+
+/*************************************************************************************************/
+const RecentLogReceiver::Slot* RecentLogReceiver::find_slot(unsigned long long sequence) {
+	const RecentLogReceiver::Slot* self = nullptr;
+
+	if ((sequence > 0ULL) && (sequence + this->ring.size() > this->sequence)) {
+		self = &this->ring[sequence % this->ring.size()];
+	}
+
+	return self;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <shared_mutex>
+
+#include "syslog/logging.hpp"
+
+#include "datum/enum.hpp"
+
+namespace WarGrey::SCADA {
+	private struct RecentLogRecord {
+		unsigned long long sequence;
+		WarGrey::SCADA::Log level;
+		Platform::String^ topic;
+		Platform::String^ message;
+		Platform::String^ timestamp;
+		long long timepoint; // 100ns
+	};
+
+	/** NOTE
+	 * The most recent `capacity` records are kept in a ring, every record links to the previous one of the same level,
+	 *   and to the previous one of the same level and topic, so that a query walks (almost) only the records it returns,
+	 *   a query with a minimum level merges the chains of all levels above it.
+	 *
+	 * Writers hold the lock exclusively only while filling a slot, queries share the lock with each other.
+	 */
+	private class RecentLogReceiver : public WarGrey::SCADA::ISyslogReceiver {
+	public:
+		RecentLogReceiver(size_t capacity = 4096U, WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = "");
+
+	public:
+		/** NOTE
+		 * Collect the last `count` records (in the order they were logged) whose level is at least `min_level`,
+		 *   whose topic is `topic` (any topic if `nullptr`), and whose sequence is greater than `since`,
+		 *   so that displays can refresh with the last sequence they have seen.
+		 */
+		size_t query(std::vector<WarGrey::SCADA::RecentLogRecord>& records, size_t count,
+			WarGrey::SCADA::Log min_level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = nullptr,
+			unsigned long long since = 0ULL);
+
+		unsigned long long last_sequence();
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		~RecentLogReceiver() noexcept {}
+
+	private:
+		struct Slot {
+			WarGrey::SCADA::RecentLogRecord record;
+			unsigned long long prev_of_level;
+			unsigned long long prev_of_topic; // of the same level and topic
+		};
+
+		struct Chains {
+			unsigned long long heads[_N(WarGrey::SCADA::Log)];
+		};
+
+	private:
+		const WarGrey::SCADA::RecentLogReceiver::Slot* find_slot(unsigned long long sequence);
+
+	private:
+		std::shared_mutex section;
+		std::vector<WarGrey::SCADA::RecentLogReceiver::Slot> ring;
+		WarGrey::SCADA::RecentLogReceiver::Chains levels;
+		std::map<std::wstring, WarGrey::SCADA::RecentLogReceiver::Chains> topics;
+		unsigned long long sequence = 0ULL;
+	};
+}
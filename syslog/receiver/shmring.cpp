@@ -0,0 +1,186 @@
+#include <cstring>
+#include <Windows.h>
+
+#include "syslog/receiver/shmring.hpp"
+
+#include "datum/enum.hpp"
+#include "datum/time.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+static unsigned long long ring_capacity(size_t capacity) {
+	unsigned long long size = 64ULL * 1024ULL;
+
+	while (size < capacity) {
+		size <<= 1U;
+	}
+
+	return size;
+}
+
+static inline size_t record_size(size_t payload) {
+	return (sizeof(SharedLogRecordHeader) + payload + 0x7U) & ~size_t(0x7U);
+}
+
+/*************************************************************************************************/
+SharedRingReceiver::SharedRingReceiver(Platform::String^ name, size_t capacity, Log level, Platform::String^ topic)
+	: ISyslogReceiver(level, topic), name(name), capacity(ring_capacity(capacity)), head(0ULL), tail(0ULL) {
+	this->path = ApplicationData::Current->LocalFolder->Path + "\\" + name + ".ring";
+	this->header = shared_log_ring_map(this->path, this->capacity, &this->file, &this->mapping);
+
+	for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+		this->events[idx] = nullptr;
+	}
+
+	if (this->header != nullptr) {
+		if (shared_log_ring_header_okay(this->header, this->capacity)) {
+			// collectors keep reading across restarts of the application
+			this->head = this->header->head.load();
+			this->tail = this->header->tail.load();
+		} else {
+			shared_log_ring_make_header(this->header, this->capacity);
+		}
+
+		this->records = reinterpret_cast<unsigned char*>(this->header) + this->header->header_size;
+
+		for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+			Platform::String^ ename = shared_log_ring_event_name(name, idx);
+
+			this->events[idx] = CreateEventExW(nullptr, ename->Data(), 0, EVENT_MODIFY_STATE | SYNCHRONIZE);
+		}
+	}
+}
+
+SharedRingReceiver::~SharedRingReceiver() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+		if (this->events[idx] != nullptr) {
+			CloseHandle(this->events[idx]);
+			this->events[idx] = nullptr;
+		}
+	}
+
+	shared_log_ring_unmap(this->header, this->mapping, this->file);
+	this->header = nullptr;
+}
+
+Platform::String^ SharedRingReceiver::ring_path() {
+	return this->path;
+}
+
+Platform::String^ SharedRingReceiver::ring_name() {
+	return this->name;
+}
+
+bool SharedRingReceiver::is_open() {
+	return (this->header != nullptr);
+}
+
+void SharedRingReceiver::on_log_message(Log level, Platform::String^ message, SyslogMetainfo& data, Platform::String^ topic) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (this->header != nullptr) {
+		size_t max_payload = size_t(this->capacity / 4ULL) - sizeof(SharedLogRecordHeader);
+		unsigned int topic_length = ((topic == nullptr) ? 0U : topic->Length());
+		unsigned int message_length = ((message == nullptr) ? 0U : message->Length());
+		size_t offset = size_t(this->head & (this->capacity - 1ULL));
+		size_t room = size_t(this->capacity - offset);
+		SharedLogRecordHeader rh;
+		size_t size = 0U;
+
+		if (topic_length * sizeof(wchar_t) > max_payload / 2U) {
+			topic_length = (unsigned int)(max_payload / 2U / sizeof(wchar_t));
+		}
+
+		if ((topic_length + message_length) * sizeof(wchar_t) > max_payload) {
+			message_length = (unsigned int)(max_payload / sizeof(wchar_t)) - topic_length;
+		}
+
+		size = record_size((topic_length + message_length) * sizeof(wchar_t));
+
+		if (room < size) {
+			this->reserve(this->head + room);
+
+			if (room >= sizeof(SharedLogRecordHeader)) {
+				memset(&rh, 0, sizeof(SharedLogRecordHeader));
+				rh.size = (unsigned int)(room);
+				rh.type = _I(SharedLogRecordType::Padding);
+				rh.sequence = this->header->sequence.load(std::memory_order_relaxed);
+				memcpy(this->records + offset, &rh, sizeof(SharedLogRecordHeader));
+			}
+
+			this->head += room;
+			offset = 0U;
+		}
+
+		this->reserve(this->head + size);
+
+		rh.size = (unsigned int)(size);
+		rh.type = _I(SharedLogRecordType::Message);
+		rh.level = _C(level);
+		rh.reserved = 0U;
+		rh.sequence = this->header->sequence.fetch_add(1ULL, std::memory_order_relaxed);
+		rh.timestamp = ((data.timepoint > 0LL) ? data.timepoint : current_100nanoseconds());
+		rh.topic_length = topic_length;
+		rh.message_length = message_length;
+
+		memcpy(this->records + offset, &rh, sizeof(SharedLogRecordHeader));
+		offset += sizeof(SharedLogRecordHeader);
+
+		if (topic_length > 0U) {
+			memcpy(this->records + offset, topic->Data(), topic_length * sizeof(wchar_t));
+			offset += topic_length * sizeof(wchar_t);
+		}
+
+		if (message_length > 0U) {
+			memcpy(this->records + offset, message->Data(), message_length * sizeof(wchar_t));
+		}
+
+		this->head += size;
+		this->header->head.store(this->head, std::memory_order_release);
+		this->wakeup();
+	}
+}
+
+/*************************************************************************************************/
+void SharedRingReceiver::reserve(unsigned long long end) {
+	unsigned long long oldest = this->tail;
+
+	while (oldest + this->capacity < end) {
+		size_t offset = size_t(oldest & (this->capacity - 1ULL));
+		size_t room = size_t(this->capacity - offset);
+		unsigned int size = 0U;
+
+		if (room >= sizeof(SharedLogRecordHeader)) {
+			memcpy(&size, this->records + offset, sizeof(unsigned int));
+		}
+
+		oldest += (((size >= sizeof(SharedLogRecordHeader)) && (size <= room)) ? size : room);
+	}
+
+	if (oldest != this->tail) {
+		this->tail = oldest;
+
+		// readers should see the new tail before any byte of the records behind it gets overwritten
+		this->header->tail.store(oldest, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+}
+
+void SharedRingReceiver::wakeup() {
+	// pairs with readers that set `waiting` before checking the head
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+		SharedLogRingReaderSlot* slot = &this->header->readers[idx];
+
+		if ((slot->waiting.load(std::memory_order_relaxed) != 0U) && (slot->waiting.exchange(0U) != 0U)) {
+			if (this->events[idx] != nullptr) {
+				SetEvent(this->events[idx]);
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mutex>
+
+#include "syslog/logging.hpp"
+#include "syslog/shmring.hpp"
+
+namespace WarGrey::SCADA {
+	/** NOTE
+	 * Records are written into a shared log ring file (see `syslog/shmring.hpp`) in the local folder of the application,
+	 *   so that a collector process on the same machine reads them without any syscall or socket in between,
+	 *   and readers waiting for records are woken up by their events.
+	 *
+	 * The ring never blocks the writer, the oldest records are overwritten, and readers tell how many they lost.
+	 * Messages longer than a quarter of the capacity are truncated.
+	 */
+	private class SharedRingReceiver : public WarGrey::SCADA::ISyslogReceiver {
+	public:
+		SharedRingReceiver(Platform::String^ name = "syslog", size_t capacity = 4U * 1024U * 1024U,
+			WarGrey::SCADA::Log level = WarGrey::SCADA::Log::Debug, Platform::String^ topic = "");
+
+	public:
+		Platform::String^ ring_path();
+		Platform::String^ ring_name();
+		bool is_open();
+
+	protected:
+		void on_log_message(WarGrey::SCADA::Log level, Platform::String^ message,
+			WarGrey::SCADA::SyslogMetainfo& data, Platform::String^ topic) override;
+
+	protected:
+		~SharedRingReceiver() noexcept;
+
+	private: // with `section` locked
+		void reserve(unsigned long long end);
+		void wakeup();
+
+	private:
+		std::mutex section;
+		Platform::String^ path;
+		Platform::String^ name;
+		void* file = nullptr;
+		void* mapping = nullptr;
+		void* events[WarGrey::SCADA::shared_log_ring_reader_count];
+		WarGrey::SCADA::SharedLogRingHeader* header = nullptr;
+		unsigned char* records = nullptr;
+
+	private:
+		unsigned long long capacity;
+		unsigned long long head;
+		unsigned long long tail;
+	};
+}
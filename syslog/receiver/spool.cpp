@@ -0,0 +1,275 @@
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <Windows.h>
+
+#include "syslog/receiver/spool.hpp"
+
+using namespace WarGrey::SCADA;
+
+using namespace Windows::Storage;
+
+/*************************************************************************************************/
+SyslogSpool::SyslogSpool(Platform::String^ dirname, Platform::String^ prefix, unsigned long long max_size, RotationPeriod period)
+	: IRotativeDirectory(dirname, prefix, ".spool", period, 1U), max_size(max_size) {
+	this->counters.segments = 0U;
+	this->counters.backlog = 0ULL;
+	this->counters.spooled = 0ULL;
+	this->counters.replayed = 0ULL;
+	this->counters.dropped = 0ULL;
+}
+
+SyslogSpool::~SyslogSpool() {
+	this->dispose();
+
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->closed = true;
+
+	if (this->writer != nullptr) {
+		CloseHandle(this->writer);
+		this->writer = nullptr;
+	}
+
+	if (this->reader != nullptr) {
+		CloseHandle(this->reader);
+		this->reader = nullptr;
+	}
+}
+
+bool SyslogSpool::append(const char* line, size_t size) {
+	std::unique_lock<std::mutex> guard(this->section);
+	bool okay = ((!this->closed) && (this->writer != nullptr));
+
+	if (okay) {
+		// the oldest lines are the least valuable ones after hours of outage
+		while ((this->total_size + size + 1U > this->max_size) && (this->segments.size() > 1U)) {
+			this->drop_front_segment();
+		}
+
+		if (this->total_size + size + 1U > this->max_size) {
+			this->counters.dropped++;
+		} else {
+			DWORD written = 0;
+
+			this->buffer.assign(line, size);
+			this->buffer.push_back('\n');
+
+			if (WriteFile(this->writer, this->buffer.data(), DWORD(this->buffer.size()), &written, nullptr)) {
+				this->segments.back().size += written;
+				this->total_size += written;
+				this->counters.spooled++;
+			} else {
+				this->counters.dropped++;
+			}
+		}
+	}
+
+	return okay;
+}
+
+size_t SyslogSpool::peek(std::string& datagram, size_t mtu) {
+	std::unique_lock<std::mutex> guard(this->section);
+	size_t consumed = 0U;
+
+	datagram.clear();
+
+	while ((consumed == 0U) && (!this->segments.empty()) && (!this->closed)) {
+		SyslogSpool::Segment* front = &this->segments.front();
+		bool writing = ((this->segments.size() == 1U) && (this->writer != nullptr));
+
+		if (this->read_offset >= front->size) {
+			if (writing) {
+				break;
+			}
+
+			this->drop_front_segment();
+		} else if (this->reader == nullptr) {
+			HANDLE reader = CreateFile2(front->path.c_str(), GENERIC_READ,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, OPEN_EXISTING, nullptr);
+
+			if (reader == INVALID_HANDLE_VALUE) {
+				this->drop_front_segment();
+			} else {
+				this->reader = reader;
+			}
+		} else {
+			size_t size = size_t(std::min(front->size - this->read_offset, (unsigned long long)(mtu) + 1ULL));
+			OVERLAPPED position = {};
+			DWORD read = 0;
+
+			this->buffer.resize(size);
+			position.Offset = DWORD(this->read_offset & 0xFFFFFFFFULL);
+			position.OffsetHigh = DWORD(this->read_offset >> 32U);
+
+			if ((!ReadFile(this->reader, &this->buffer[0], DWORD(size), &read, &position)) || (read == 0)) {
+				this->drop_front_segment();
+			} else {
+				size_t start = 0U;
+
+				while (start < read) {
+					const char* eol = (const char*)memchr(this->buffer.data() + start, '\n', read - start);
+
+					if (eol == nullptr) {
+						if (start == 0U) {
+							// a line longer than the datagram, split it
+							datagram.assign(this->buffer.data(), std::min(size_t(read), mtu));
+							consumed = datagram.size();
+						}
+
+						break;
+					} else {
+						size_t line_size = size_t(eol - (this->buffer.data() + start));
+
+						if ((!datagram.empty()) && (datagram.size() + 1U + line_size > mtu)) {
+							break;
+						}
+
+						if (!datagram.empty()) {
+							datagram.push_back('\n');
+						}
+
+						datagram.append(this->buffer.data() + start, line_size);
+						start += line_size + 1U;
+						consumed = start;
+					}
+				}
+			}
+		}
+	}
+
+	this->peeked = consumed;
+
+	return consumed;
+}
+
+void SyslogSpool::consume(size_t size) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	// the peeked segment might have been dropped in the meantime
+	size = std::min(size, this->peeked);
+
+	this->read_offset += size;
+	this->counters.replayed += size;
+	this->peeked = 0U;
+
+	if ((!this->segments.empty()) && (this->read_offset >= this->segments.front().size)) {
+		if ((this->segments.size() > 1U) || (this->writer == nullptr)) {
+			this->drop_front_segment();
+		}
+	}
+}
+
+bool SyslogSpool::empty() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	return (this->segments.empty()
+		|| ((this->segments.size() == 1U) && (this->read_offset >= this->segments.front().size)));
+}
+
+void SyslogSpool::statistics(SyslogSpoolStatistics* stat) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->counters.segments = this->segments.size();
+	this->counters.backlog = this->total_size - this->read_offset;
+
+	(*stat) = this->counters;
+}
+
+/*************************************************************************************************/
+void SyslogSpool::on_folder_ready(StorageFolder^ folder, bool newly_folder) {
+	if (!newly_folder) {
+		Platform::String^ pattern = folder->Path + "\\*.spool";
+		std::vector<std::pair<std::wstring, unsigned long long>> leftovers;
+		WIN32_FIND_DATAW data;
+		HANDLE finder = FindFirstFileExW(pattern->Data(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, 0);
+
+		if (finder != INVALID_HANDLE_VALUE) {
+			do {
+				if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+					unsigned long long size = (((unsigned long long)(data.nFileSizeHigh)) << 32U) | data.nFileSizeLow;
+
+					leftovers.push_back({ std::wstring(folder->Path->Data()) + L"\\" + data.cFileName, size });
+				}
+			} while (FindNextFileW(finder, &data));
+
+			FindClose(finder);
+		}
+
+		// filenames are timestamped, so that the older the smaller
+		std::sort(leftovers.begin(), leftovers.end());
+
+		{ // segments of this run come after the ones of previous runs
+			std::unique_lock<std::mutex> guard(this->section);
+
+			for (auto it = leftovers.rbegin(); it != leftovers.rend(); it++) {
+				this->segments.push_front({ it->first, it->second });
+				this->total_size += it->second;
+			}
+		}
+	}
+}
+
+void SyslogSpool::on_file_rotated(StorageFile^ prev_file, StorageFile^ current_file, long long timepoint) {
+	HANDLE file = CreateFile2(current_file->Path->Data(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, OPEN_ALWAYS, nullptr);
+	std::unique_lock<std::mutex> guard(this->section);
+
+	if (this->closed) {
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+	} else {
+		std::wstring path(current_file->Path->Data(), current_file->Path->Length());
+
+		if (this->writer != nullptr) {
+			CloseHandle(this->writer);
+			this->writer = nullptr;
+		}
+
+		if (file != INVALID_HANDLE_VALUE) {
+			this->writer = file;
+
+			// the current file of this period might be a leftover
+			if (this->segments.empty() || (this->segments.back().path.compare(path) != 0)) {
+				LARGE_INTEGER file_size;
+				unsigned long long size = 0ULL;
+
+				if (GetFileSizeEx(file, &file_size)) {
+					size = (unsigned long long)(file_size.QuadPart);
+				}
+
+				this->segments.push_back({ path, size });
+				this->total_size += size;
+			}
+		}
+	}
+}
+
+void SyslogSpool::on_exception(Platform::Exception^ e) {
+	/** keep silent
+	 * A failed rotation leaves the previous segment open for appending,
+	 *   `append()` only refuses lines before the first segment is ready, and the caller keeps them.
+	 */
+}
+
+/*************************************************************************************************/
+void SyslogSpool::drop_front_segment() {
+	SyslogSpool::Segment* front = &this->segments.front();
+
+	if (this->reader != nullptr) {
+		CloseHandle(this->reader);
+		this->reader = nullptr;
+	}
+
+	if ((this->segments.size() == 1U) && (this->writer != nullptr)) {
+		// never delete the segment being written
+		this->read_offset = front->size;
+	} else {
+		DeleteFileW(front->path.c_str());
+		this->total_size -= front->size;
+		this->segments.pop_front();
+		this->read_offset = 0ULL;
+	}
+
+	this->peeked = 0U;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "dirotation.hpp"
+
+namespace WarGrey::SCADA {
+	private struct SyslogSpoolStatistics {
+		size_t segments;
+		unsigned long long backlog;  // bytes not replayed yet
+		unsigned long long spooled;  // lines
+		unsigned long long replayed; // bytes
+		unsigned long long dropped;  // lines, due to `max_size`
+	};
+
+	/** NOTE
+	 * An append-only queue of UTF-8 lines on disk, segmented by `IRotativeDirectory`,
+	 *   the oldest segment is deleted once it has been fully replayed, or once the spool is larger than `max_size`.
+	 *
+	 * Lines are replayed in the order they were spooled, `peek` fills a datagram without consuming the lines,
+	 *   so that they can be replayed again if the datagram is lost.
+	 *
+	 * Segments left by the previous run are replayed too, the partially replayed one is replayed from the beginning.
+	 */
+	private class SyslogSpool : public WarGrey::SCADA::IRotativeDirectory {
+	public:
+		virtual ~SyslogSpool() noexcept;
+		SyslogSpool(Platform::String^ dirname, Platform::String^ file_prefix,
+			unsigned long long max_size = 256ULL * 1024ULL * 1024ULL,
+			WarGrey::SCADA::RotationPeriod period = WarGrey::SCADA::RotationPeriod::Hourly);
+
+	public:
+		bool append(const char* line, size_t size); // `false` if no segment is open yet
+		size_t peek(std::string& datagram, size_t mtu);
+		void consume(size_t size);
+		bool empty();
+
+	public:
+		void statistics(WarGrey::SCADA::SyslogSpoolStatistics* stat);
+
+	protected:
+		void on_folder_ready(Windows::Storage::StorageFolder^ path, bool newly_folder) override;
+		void on_file_rotated(Windows::Storage::StorageFile^ prev_file, Windows::Storage::StorageFile^ current_file, long long timepoint) override;
+		void on_exception(Platform::Exception^ e) override;
+
+	private:
+		void drop_front_segment(); // with `section` locked
+
+	private:
+		struct Segment {
+			std::wstring path;
+			unsigned long long size;
+		};
+
+	private:
+		std::mutex section;
+		std::deque<WarGrey::SCADA::SyslogSpool::Segment> segments;
+		std::string buffer;
+		void* writer = nullptr;
+		void* reader = nullptr;
+		unsigned long long read_offset = 0ULL;
+		size_t peeked = 0U;
+		unsigned long long total_size = 0ULL;
+		bool closed = false;
+
+	private:
+		WarGrey::SCADA::SyslogSpoolStatistics counters;
+		unsigned long long max_size;
+	};
+}
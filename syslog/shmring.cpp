@@ -0,0 +1,318 @@
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <Windows.h>
+
+#include "syslog/shmring.hpp"
+
+#include "datum/enum.hpp"
+
+using namespace WarGrey::SCADA;
+
+static_assert(std::atomic<unsigned long long>::is_always_lock_free, "the ring is shared among processes");
+static_assert(sizeof(SharedLogRingHeader) <= shared_log_ring_header_size, "the header should fit in a page");
+static_assert(sizeof(SharedLogRecordHeader) == 32U, "the record header is 32 bytes");
+
+static const unsigned short shared_log_ring_version = 1U;
+
+/*************************************************************************************************/
+SharedLogRingHeader* WarGrey::SCADA::shared_log_ring_map(Platform::String^ path, unsigned long long capacity, void** file, void** mapping) {
+	DWORD disposition = ((capacity > 0ULL) ? OPEN_ALWAYS : OPEN_EXISTING);
+	HANDLE ring = CreateFile2(path->Data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, disposition, nullptr);
+	SharedLogRingHeader* header = nullptr;
+
+	if (ring != INVALID_HANDLE_VALUE) {
+		HANDLE map = nullptr;
+		LARGE_INTEGER file_size;
+
+		if ((capacity == 0ULL) && GetFileSizeEx(ring, &file_size)) {
+			if ((unsigned long long)(file_size.QuadPart) > shared_log_ring_header_size) {
+				capacity = (unsigned long long)(file_size.QuadPart) - shared_log_ring_header_size;
+			}
+		}
+
+		if (capacity > 0ULL) {
+			map = CreateFileMappingFromApp(ring, nullptr, PAGE_READWRITE, shared_log_ring_header_size + capacity, nullptr);
+		}
+
+		if (map != nullptr) {
+			header = static_cast<SharedLogRingHeader*>(MapViewOfFileFromApp(map, FILE_MAP_READ | FILE_MAP_WRITE,
+				0ULL, size_t(shared_log_ring_header_size + capacity)));
+		}
+
+		if (header != nullptr) {
+			(*file) = ring;
+			(*mapping) = map;
+		} else {
+			if (map != nullptr) {
+				CloseHandle(map);
+			}
+
+			CloseHandle(ring);
+		}
+	}
+
+	return header;
+}
+
+void WarGrey::SCADA::shared_log_ring_unmap(SharedLogRingHeader* header, void* mapping, void* file) {
+	if (header != nullptr) {
+		UnmapViewOfFile(header);
+	}
+
+	if (mapping != nullptr) {
+		CloseHandle(mapping);
+	}
+
+	if (file != nullptr) {
+		CloseHandle(file);
+	}
+}
+
+bool WarGrey::SCADA::shared_log_ring_header_okay(const SharedLogRingHeader* header, unsigned long long capacity) {
+	return ((memcmp(header->magic, "WGSR", sizeof(header->magic)) == 0)
+		&& (header->version == shared_log_ring_version)
+		&& (header->wchar_size == sizeof(wchar_t))
+		&& (header->header_size == shared_log_ring_header_size)
+		&& (header->capacity > 0ULL) && ((header->capacity & (header->capacity - 1ULL)) == 0ULL)
+		&& ((capacity == 0ULL) || (header->capacity == capacity)));
+}
+
+void WarGrey::SCADA::shared_log_ring_make_header(SharedLogRingHeader* header, unsigned long long capacity) {
+	memset(header, 0, shared_log_ring_header_size);
+	memcpy(header->magic, "WGSR", sizeof(header->magic));
+
+	header->version = shared_log_ring_version;
+	header->wchar_size = (unsigned short)(sizeof(wchar_t));
+	header->header_size = shared_log_ring_header_size;
+	header->capacity = capacity;
+	header->sequence.store(1ULL);
+	header->head.store(0ULL);
+	header->tail.store(0ULL);
+
+	for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+		header->readers[idx].claimed.store(0U);
+		header->readers[idx].waiting.store(0U);
+	}
+}
+
+Platform::String^ WarGrey::SCADA::shared_log_ring_event_name(Platform::String^ name, unsigned int slot) {
+	return name + "-" + slot.ToString();
+}
+
+/*************************************************************************************************/
+SharedLogRingReader::SharedLogRingReader() {}
+
+SharedLogRingReader::~SharedLogRingReader() {
+	this->close();
+}
+
+bool SharedLogRingReader::open(Platform::String^ path, Platform::String^ name, bool from_oldest) {
+	this->close();
+	this->header = shared_log_ring_map(path, 0ULL, &this->file, &this->mapping);
+
+	if (this->header != nullptr) {
+		if (!shared_log_ring_header_okay(this->header)) {
+			this->close();
+		} else {
+			this->records = reinterpret_cast<unsigned char*>(this->header) + this->header->header_size;
+			this->count = 0ULL;
+			this->lost = 0ULL;
+
+			if (!from_oldest) {
+				this->next_sequence = this->header->sequence.load(std::memory_order_acquire);
+				this->cursor = this->header->head.load(std::memory_order_acquire);
+			} else {
+				do {
+					this->cursor = this->header->tail.load(std::memory_order_acquire);
+					this->next_sequence = this->sequence_at(this->cursor);
+				} while (this->header->tail.load(std::memory_order_relaxed) > this->cursor);
+			}
+
+			for (unsigned int idx = 0; idx < shared_log_ring_reader_count; idx++) {
+				unsigned int free_slot = 0U;
+
+				if (this->header->readers[idx].claimed.compare_exchange_strong(free_slot, 1U)) {
+					Platform::String^ ename = shared_log_ring_event_name(name, idx);
+
+					this->event = CreateEventExW(nullptr, ename->Data(), 0, EVENT_MODIFY_STATE | SYNCHRONIZE);
+
+					if (this->event == nullptr) {
+						this->header->readers[idx].claimed.store(0U);
+					} else {
+						this->slot = int(idx);
+					}
+
+					break;
+				}
+			}
+		}
+	}
+
+	return this->is_open();
+}
+
+bool SharedLogRingReader::is_open() {
+	return (this->header != nullptr);
+}
+
+void SharedLogRingReader::close() {
+	if (this->slot >= 0) {
+		this->header->readers[this->slot].waiting.store(0U);
+		this->header->readers[this->slot].claimed.store(0U);
+		this->slot = -1;
+	}
+
+	if (this->event != nullptr) {
+		CloseHandle(this->event);
+		this->event = nullptr;
+	}
+
+	shared_log_ring_unmap(this->header, this->mapping, this->file);
+	this->header = nullptr;
+	this->records = nullptr;
+	this->mapping = nullptr;
+	this->file = nullptr;
+}
+
+bool SharedLogRingReader::read(SharedLogEntry* entry) {
+	bool okay = false;
+
+	if (this->header != nullptr) {
+		unsigned long long capacity = this->header->capacity;
+
+		while (!okay) {
+			unsigned long long head = this->header->head.load(std::memory_order_acquire);
+			unsigned long long tail = this->header->tail.load(std::memory_order_acquire);
+			SharedLogRecordHeader rh;
+			size_t offset = 0U;
+			size_t room = 0U;
+			bool intact = false;
+
+			if (this->cursor < tail) {
+				// the lost records are counted by the gap of sequences
+				this->cursor = tail;
+			}
+
+			if (this->cursor >= head) {
+				break;
+			}
+
+			offset = size_t(this->cursor & (capacity - 1ULL));
+			room = size_t(capacity - offset);
+
+			if (room < sizeof(SharedLogRecordHeader)) {
+				this->cursor += room;
+				continue;
+			}
+
+			memcpy(&rh, this->records + offset, sizeof(SharedLogRecordHeader));
+			intact = ((rh.size >= sizeof(SharedLogRecordHeader)) && (rh.size <= room) && ((rh.size & 0x7U) == 0U));
+
+			if (intact && (rh.type == _I(SharedLogRecordType::Message))) {
+				size_t payload = (size_t(rh.topic_length) + size_t(rh.message_length)) * sizeof(wchar_t);
+
+				intact = (sizeof(SharedLogRecordHeader) + payload <= rh.size);
+
+				if (intact) {
+					this->record.resize(payload + sizeof(wchar_t));
+					memcpy(this->record.data(), this->records + offset + sizeof(SharedLogRecordHeader), payload);
+				}
+			}
+
+			// the writer moves the tail before overwriting, so a record is intact if it is still behind the tail
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (this->header->tail.load(std::memory_order_relaxed) > this->cursor) {
+				continue;
+			}
+
+			if (!intact) {
+				// not supposed to happen, skip whatever has been written
+				this->cursor = head;
+				continue;
+			}
+
+			this->cursor += rh.size;
+
+			if (rh.type == _I(SharedLogRecordType::Message)) {
+				const wchar_t* topic = reinterpret_cast<const wchar_t*>(this->record.data());
+
+				if ((this->next_sequence > 0ULL) && (rh.sequence > this->next_sequence)) {
+					this->lost += (rh.sequence - this->next_sequence);
+				}
+
+				this->next_sequence = rh.sequence + 1ULL;
+				this->count++;
+
+				entry->sequence = rh.sequence;
+				entry->timestamp = rh.timestamp;
+				entry->level = _E(Log, rh.level);
+				entry->topic = ((rh.topic_length == 0U) ? nullptr : ref new Platform::String(topic, rh.topic_length));
+				entry->message = ref new Platform::String(topic + rh.topic_length, rh.message_length);
+
+				okay = true;
+			}
+		}
+	}
+
+	return okay;
+}
+
+unsigned long long SharedLogRingReader::sequence_at(unsigned long long position) {
+	unsigned long long capacity = this->header->capacity;
+	unsigned long long sequence = this->header->sequence.load(std::memory_order_acquire);
+
+	if (position < this->header->head.load(std::memory_order_acquire)) {
+		size_t offset = size_t(position & (capacity - 1ULL));
+		SharedLogRecordHeader rh;
+
+		if (capacity - offset < sizeof(SharedLogRecordHeader)) {
+			offset = 0U;
+		}
+
+		// paddings carry the sequence of the next message
+		memcpy(&rh, this->records + offset, sizeof(SharedLogRecordHeader));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		sequence = rh.sequence;
+	}
+
+	return sequence;
+}
+
+bool SharedLogRingReader::wait(unsigned int timeout_ms) {
+	bool ready = false;
+
+	if (this->header != nullptr) {
+		ready = (this->cursor < this->header->head.load(std::memory_order_acquire));
+
+		if (!ready) {
+			if (this->slot >= 0) {
+				SharedLogRingReaderSlot* self = &this->header->readers[this->slot];
+
+				// pairs with the writer that publishes the head before checking `waiting`
+				self->waiting.store(1U, std::memory_order_seq_cst);
+				ready = (this->cursor < this->header->head.load(std::memory_order_seq_cst));
+
+				if (!ready) {
+					WaitForSingleObjectEx(this->event, timeout_ms, FALSE);
+					ready = (this->cursor < this->header->head.load(std::memory_order_acquire));
+				}
+
+				self->waiting.store(0U, std::memory_order_relaxed);
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+				ready = (this->cursor < this->header->head.load(std::memory_order_acquire));
+			}
+		}
+	}
+
+	return ready;
+}
+
+unsigned long long SharedLogRingReader::read_count() {
+	return this->count;
+}
+
+unsigned long long SharedLogRingReader::lost_count() {
+	return this->lost;
+}
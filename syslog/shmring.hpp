@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "syslog/logging.hpp"
+
+namespace WarGrey::SCADA {
+	private enum class SharedLogRecordType { Message = 1, Padding = 2 };
+
+	static const unsigned int shared_log_ring_reader_count = 8U;
+
+	/** NOTE
+	 * A shared log ring is a file mapped by one writer and several readers, it starts with the following header (one page),
+	 *   followed by `capacity` (a power of 2) bytes of records that all start with the following 32-byte header,
+	 *   `size` includes the header itself and is a multiple of 8, the topic and the message follow the header as UTF-16.
+	 *
+	 * Positions only grow, a record at `position` is located at `position & (capacity - 1)` and never straddles the end,
+	 *   the writer inserts a `Padding` record (or leaves less than 32 bytes alone) instead.
+	 *
+	 * `tail` is the position of the oldest intact record, the writer moves it forward before overwriting anything,
+	 *   so that readers check it after copying a record to know whether the record was overwritten in the meantime,
+	 *   and the gaps in sequences tell them how many records they have lost (paddings carry the sequence of the next message).
+	 *
+	 * Readers claim one of the slots for wakeups, every slot owns a named auto-reset event `name-i`,
+	 *   which is set by the writer only if the reader is waiting.
+	 */
+	private struct SharedLogRingReaderSlot {
+		std::atomic<unsigned int> claimed;
+		std::atomic<unsigned int> waiting;
+	};
+
+	private struct SharedLogRingHeader {
+		char magic[4];
+		unsigned short version;
+		unsigned short wchar_size;
+		unsigned int header_size;
+		unsigned int reserved;
+		unsigned long long capacity;
+		std::atomic<unsigned long long> sequence; // the next one
+
+		alignas(64) std::atomic<unsigned long long> head;
+		alignas(64) std::atomic<unsigned long long> tail;
+		alignas(64) WarGrey::SCADA::SharedLogRingReaderSlot readers[shared_log_ring_reader_count];
+	};
+
+	private struct SharedLogRecordHeader {
+		unsigned int size;
+		unsigned short type;
+		unsigned char level;
+		unsigned char reserved;
+		unsigned long long sequence;
+		long long timestamp;
+		unsigned int topic_length;
+		unsigned int message_length;
+	};
+
+	static const unsigned int shared_log_ring_header_size = 4096U;
+
+	/** NOTE
+	 * Map the ring file for both the writer and readers,
+	 *   the file is created (or extended) if `capacity` is positive, otherwise the capacity is taken from the existing file.
+	 */
+	WarGrey::SCADA::SharedLogRingHeader* shared_log_ring_map(Platform::String^ path, unsigned long long capacity, void** file, void** mapping);
+	void shared_log_ring_unmap(WarGrey::SCADA::SharedLogRingHeader* header, void* mapping, void* file);
+
+	bool shared_log_ring_header_okay(const WarGrey::SCADA::SharedLogRingHeader* header, unsigned long long capacity = 0ULL);
+	void shared_log_ring_make_header(WarGrey::SCADA::SharedLogRingHeader* header, unsigned long long capacity);
+	Platform::String^ shared_log_ring_event_name(Platform::String^ name, unsigned int slot);
+
+	/*********************************************************************************************/
+	private struct SharedLogEntry {
+		unsigned long long sequence;
+		long long timestamp;
+		WarGrey::SCADA::Log level;
+		Platform::String^ topic;
+		Platform::String^ message;
+	};
+
+	private class SharedLogRingReader {
+	public:
+		virtual ~SharedLogRingReader() noexcept;
+		SharedLogRingReader();
+
+	public:
+		/** NOTE
+		 * `name` is the one the writer uses for its events, a reader without a free slot can only poll.
+		 * Slots of crashed readers are not reclaimed until the ring file is recreated.
+		 */
+		bool open(Platform::String^ path, Platform::String^ name, bool from_oldest = true);
+		bool is_open();
+		void close();
+
+	public:
+		bool read(WarGrey::SCADA::SharedLogEntry* entry);
+		bool wait(unsigned int timeout_ms); // `true` if there are records to read
+
+	public:
+		unsigned long long read_count();
+		unsigned long long lost_count();
+
+	private:
+		unsigned long long sequence_at(unsigned long long position);
+
+	private:
+		void* file = nullptr;
+		void* mapping = nullptr;
+		void* event = nullptr;
+		WarGrey::SCADA::SharedLogRingHeader* header = nullptr;
+		unsigned char* records = nullptr;
+		int slot = -1;
+
+	private:
+		std::vector<unsigned char> record;
+		unsigned long long cursor = 0ULL;
+		unsigned long long next_sequence = 0ULL;
+		unsigned long long count = 0ULL;
+		unsigned long long lost = 0ULL;
+	};
+}
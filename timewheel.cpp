@@ -0,0 +1,304 @@
+#include <chrono>
+
+#include "timewheel.hpp"
+
+#include "datum/time.hpp"
+
+#include "system.hpp"
+
+using namespace WarGrey::SCADA;
+
+static const unsigned int root_bits = 8U;
+static const unsigned int level_bits = 6U;
+static const unsigned int root_size = 1U << root_bits;
+static const unsigned int level_size = 1U << level_bits;
+static const unsigned long long root_mask = root_size - 1U;
+static const unsigned long long level_mask = level_size - 1U;
+static const unsigned long long max_ticks = 0xFFFFFFFFULL;
+
+static inline unsigned int level_index(unsigned long long tick, unsigned int level) {
+	return (unsigned int)((tick >> (root_bits + (level - 1U) * level_bits)) & level_mask);
+}
+
+static inline unsigned int level_offset(unsigned int level) {
+	return ((level == 0U) ? 0U : (root_size + (level - 1U) * level_size));
+}
+
+/*************************************************************************************************/
+TimingWheel* TimingWheel::shared() {
+	// Intentionally leaked, tasks may still be cancelled by static objects while exiting.
+	static TimingWheel* wheel = new TimingWheel();
+
+	return wheel;
+}
+
+TimingWheel::TimingWheel(long long tick_ms, bool threaded) : interval((tick_ms > 0LL) ? tick_ms : 1LL) {
+	for (unsigned int idx = 0; idx < sizeof(this->slots) / sizeof(ITimingWheelTask*); idx++) {
+		this->slots[idx] = nullptr;
+	}
+
+	this->origin_ms = current_monotonic_milliseconds();
+
+	if (threaded) {
+		this->ticker = std::thread([this]() { this->run(); });
+	}
+}
+
+TimingWheel::~TimingWheel() {
+	if (this->ticker.joinable()) {
+		this->section.lock();
+		this->stopping = true;
+		this->section.unlock();
+
+		this->ticking.notify_all();
+		this->ticker.join();
+	}
+}
+
+void TimingWheel::arm(ITimingWheelTask* task, long long delay_ms) {
+	if ((task->wheel != nullptr) && (task->wheel != this)) {
+		task->wheel->cancel(task);
+	}
+
+	{ // O(1)
+		long long deadline = current_monotonic_milliseconds() + ((delay_ms > 0LL) ? delay_ms : 0LL) - this->origin_ms;
+		std::unique_lock<std::mutex> guard(this->section);
+		unsigned long long expiry = (unsigned long long)((deadline > 0LL) ? ((deadline + this->interval - 1LL) / this->interval) : 0LL);
+
+		if (expiry < this->current_tick) {
+			expiry = this->current_tick;
+		} else if (expiry - this->current_tick > max_ticks) {
+			expiry = this->current_tick + max_ticks;
+		}
+
+		this->unlink(task);
+		task->expiry = expiry;
+		task->wheel = this;
+		this->link(task);
+		this->total++;
+	}
+}
+
+void TimingWheel::cancel(ITimingWheelTask* task) {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	this->unlink(task);
+
+	if (std::this_thread::get_id() != this->driver) {
+		// make sure the task is not running when it is going to be destroyed
+		this->firing_done.wait(guard, [=]() { return this->firing != task; });
+
+		// the task might re-arm itself while firing
+		this->unlink(task);
+	}
+}
+
+void TimingWheel::advance(long long now_ms) {
+	std::unique_lock<std::mutex> guard(this->section);
+	unsigned long long target = (unsigned long long)((now_ms > this->origin_ms) ? ((now_ms - this->origin_ms) / this->interval) : 0LL);
+
+	this->driver = std::this_thread::get_id();
+
+	while (this->current_tick <= target) {
+		unsigned int idx = (unsigned int)(this->current_tick & root_mask);
+
+		if ((idx == 0U) && (this->cascade(1U) == 0U) && (this->cascade(2U) == 0U) && (this->cascade(3U) == 0U)) {
+			this->cascade(4U);
+		}
+
+		while (this->slots[idx] != nullptr) {
+			ITimingWheelTask* task = this->slots[idx];
+
+			this->unlink(task);
+			this->push(&this->expired, task);
+		}
+
+		this->current_tick++;
+	}
+
+	while (this->expired != nullptr) {
+		ITimingWheelTask* task = this->expired;
+
+		this->unlink(task);
+		this->firing = task;
+		guard.unlock();
+
+		task->on_timeout(now_ms);
+
+		guard.lock();
+		this->firing = nullptr;
+		this->firing_done.notify_all();
+	}
+}
+
+long long TimingWheel::tick_ms() {
+	return this->interval;
+}
+
+long long TimingWheel::next_timeout_ms(long long now_ms) {
+	std::unique_lock<std::mutex> guard(this->section);
+	long long timeout = -1LL;
+
+	if (this->total > 0U) {
+		timeout = this->origin_ms + (long long)(this->current_tick) * this->interval - now_ms;
+
+		if (timeout < 0LL) {
+			timeout = 0LL;
+		}
+	}
+
+	return timeout;
+}
+
+size_t TimingWheel::count() {
+	return this->total;
+}
+
+/*************************************************************************************************/
+void TimingWheel::link(ITimingWheelTask* task) {
+	unsigned long long expiry = task->expiry;
+	unsigned long long distance = ((expiry > this->current_tick) ? (expiry - this->current_tick) : 0ULL);
+	unsigned int slot = 0U;
+
+	if (expiry < this->current_tick) {
+		slot = (unsigned int)(this->current_tick & root_mask);
+	} else if (distance < root_size) {
+		slot = (unsigned int)(expiry & root_mask);
+	} else if (distance < (1ULL << (root_bits + level_bits))) {
+		slot = level_offset(1U) + level_index(expiry, 1U);
+	} else if (distance < (1ULL << (root_bits + level_bits * 2U))) {
+		slot = level_offset(2U) + level_index(expiry, 2U);
+	} else if (distance < (1ULL << (root_bits + level_bits * 3U))) {
+		slot = level_offset(3U) + level_index(expiry, 3U);
+	} else {
+		slot = level_offset(4U) + level_index(expiry, 4U);
+	}
+
+	this->push(&this->slots[slot], task);
+}
+
+void TimingWheel::unlink(ITimingWheelTask* task) {
+	if (task->slot != nullptr) {
+		if (task->prev == nullptr) {
+			(*task->slot) = task->next;
+		} else {
+			task->prev->next = task->next;
+		}
+
+		if (task->next != nullptr) {
+			task->next->prev = task->prev;
+		}
+
+		if (task->slot != &this->expired) {
+			this->total--;
+		}
+
+		task->slot = nullptr;
+		task->prev = nullptr;
+		task->next = nullptr;
+		task->wheel = nullptr;
+	}
+}
+
+void TimingWheel::push(ITimingWheelTask** slot, ITimingWheelTask* task) {
+	task->slot = slot;
+	task->prev = nullptr;
+	task->next = (*slot);
+
+	if (task->next != nullptr) {
+		task->next->prev = task;
+	}
+
+	(*slot) = task;
+}
+
+unsigned int TimingWheel::cascade(unsigned int level) {
+	unsigned int idx = level_index(this->current_tick, level);
+	ITimingWheelTask** slot = &this->slots[level_offset(level) + idx];
+
+	while ((*slot) != nullptr) {
+		ITimingWheelTask* task = (*slot);
+
+		this->unlink(task);
+		task->wheel = this;
+		this->link(task);
+		this->total++;
+	}
+
+	return idx;
+}
+
+void TimingWheel::run() {
+	std::unique_lock<std::mutex> guard(this->section);
+
+	while (!this->stopping) {
+		auto next_tick = std::chrono::milliseconds(this->origin_ms + (long long)(this->current_tick) * this->interval);
+		auto now = std::chrono::milliseconds(current_monotonic_milliseconds());
+
+		if (next_tick > now) {
+			this->ticking.wait_for(guard, next_tick - now);
+		}
+
+		if (!this->stopping) {
+			guard.unlock();
+			this->advance(current_monotonic_milliseconds());
+			guard.lock();
+		}
+	}
+}
+
+/*************************************************************************************************/
+bool DisposeGate::run(std::function<void()> callback) {
+	std::unique_lock<std::recursive_mutex> guard(this->section);
+
+	if (this->alive) {
+		callback();
+	}
+
+	return this->alive;
+}
+
+void DisposeGate::close() {
+	std::unique_lock<std::recursive_mutex> guard(this->section);
+
+	this->alive = false;
+}
+
+/*************************************************************************************************/
+TimingWheelRelay::TimingWheelRelay(std::function<void(long long)> on_relay, TimingWheel* wheel)
+	: gate(std::make_shared<DisposeGate>()), on_relay(on_relay)
+	, wheel((wheel == nullptr) ? TimingWheel::shared() : wheel)
+	, dispatched((wheel == nullptr) && ui_thread_accessed()) {}
+
+TimingWheelRelay::~TimingWheelRelay() {
+	this->dispose();
+}
+
+void TimingWheelRelay::arm(long long delay_ms) {
+	this->wheel->arm(this, delay_ms);
+}
+
+void TimingWheelRelay::cancel() {
+	this->wheel->cancel(this);
+}
+
+void TimingWheelRelay::dispose() {
+	this->wheel->cancel(this);
+	this->gate->close();
+}
+
+std::shared_ptr<DisposeGate> TimingWheelRelay::get_gate() {
+	return this->gate;
+}
+
+void TimingWheelRelay::on_timeout(long long now_ms) {
+	std::shared_ptr<DisposeGate> gate = this->gate;
+	std::function<void(long long)> on_relay = this->on_relay;
+
+	if (this->dispatched) {
+		// the relay itself might be gone before the UI thread gets here
+		ui_thread_run_async([=]() { gate->run([=]() { on_relay(now_ms); }); });
+	} else {
+		gate->run([=]() { on_relay(now_ms); });
+	}
+}
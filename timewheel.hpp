@@ -0,0 +1,132 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+namespace WarGrey::SCADA {
+	class TimingWheel;
+
+	private class ITimingWheelTask abstract {
+		friend class WarGrey::SCADA::TimingWheel;
+
+	public:
+		virtual ~ITimingWheelTask() noexcept {}
+
+	public:
+		/** NOTE
+		 * Tasks are one-shot, re-arm the task here for periodic jobs.
+		 * This is invoked on the thread that drives the wheel, do not block it.
+		 */
+		virtual void on_timeout(long long now_ms) = 0;
+
+	private:
+		WarGrey::SCADA::TimingWheel* wheel = nullptr;
+		WarGrey::SCADA::ITimingWheelTask** slot = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* prev = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* next = nullptr;
+		unsigned long long expiry = 0ULL;
+	};
+
+	/** NOTE
+	 * A hierarchical timing wheel (1 level of 256 slots and 4 levels of 64 slots, 32 bits of ticks),
+	 *   arming, re-arming and cancelling are O(1), and expired tasks are cascaded down lazily.
+	 *
+	 * The shared wheel ticks every 10ms on its own thread, so that thousands of timeouts cost
+	 *   only one thread rather than one `DispatcherTimer` each on the UI thread.
+	 */
+	private class TimingWheel {
+	public:
+		static WarGrey::SCADA::TimingWheel* shared();
+
+	public:
+		virtual ~TimingWheel() noexcept;
+
+		/** NOTE
+		 * If `threaded` is false, the owner should drive the wheel with `advance()`.
+		 */
+		TimingWheel(long long tick_ms = 10LL, bool threaded = true);
+
+	public:
+		void arm(WarGrey::SCADA::ITimingWheelTask* task, long long delay_ms);
+		void cancel(WarGrey::SCADA::ITimingWheelTask* task);
+		void advance(long long now_ms);
+
+	public:
+		long long tick_ms();
+		long long next_timeout_ms(long long now_ms);
+		size_t count();
+
+	private:
+		void link(WarGrey::SCADA::ITimingWheelTask* task);
+		void unlink(WarGrey::SCADA::ITimingWheelTask* task);
+		void push(WarGrey::SCADA::ITimingWheelTask** slot, WarGrey::SCADA::ITimingWheelTask* task);
+		unsigned int cascade(unsigned int level);
+		void run();
+
+	private:
+		std::mutex section;
+		std::condition_variable firing_done;
+		std::condition_variable ticking;
+		std::thread ticker;
+		std::thread::id driver;
+		bool stopping = false;
+
+	private:
+		WarGrey::SCADA::ITimingWheelTask* slots[256 + 64 * 4];
+		WarGrey::SCADA::ITimingWheelTask* expired = nullptr;
+		WarGrey::SCADA::ITimingWheelTask* firing = nullptr;
+		unsigned long long current_tick = 0ULL;
+		long long origin_ms;
+		long long interval;
+		size_t total = 0;
+	};
+
+	/*********************************************************************************************/
+	/** NOTE
+	 * Callbacks run through a gate never run after `close()` returns,
+	 *   `close()` waits for the running one unless it is called by that callback itself.
+	 */
+	private class DisposeGate {
+	public:
+		bool run(std::function<void()> callback); // `false` if closed
+		void close();
+
+	private:
+		std::recursive_mutex section;
+		bool alive = true;
+	};
+
+	/** NOTE
+	 * A task that relays timeouts to its owner, on the UI thread if the task is created there with the shared wheel
+	 *   (as `DispatcherTimer`s used to do), otherwise on the thread that drives the wheel.
+	 *
+	 * `dispose()` (also done by the destructor) cancels the task and waits for the running callback,
+	 *   callbacks already dispatched to the UI thread are dropped once it returns.
+	 * Owners should `dispose()` the relay first in their destructors, so that no timeout is relayed to a half-destroyed object.
+	 */
+	private class TimingWheelRelay : public WarGrey::SCADA::ITimingWheelTask {
+	public:
+		virtual ~TimingWheelRelay() noexcept;
+		TimingWheelRelay(std::function<void(long long)> on_relay, WarGrey::SCADA::TimingWheel* wheel = nullptr);
+
+	public:
+		void arm(long long delay_ms);
+		void cancel();
+		void dispose();
+
+	public:
+		std::shared_ptr<WarGrey::SCADA::DisposeGate> get_gate();
+
+	protected:
+		void on_timeout(long long now_ms) override;
+
+	private:
+		std::shared_ptr<WarGrey::SCADA::DisposeGate> gate;
+		std::function<void(long long)> on_relay;
+		WarGrey::SCADA::TimingWheel* wheel;
+		bool dispatched;
+	};
+}